@@ -0,0 +1,248 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+
+#include "utils/LiteMath.h"
+#include "utils/public_camera.h"
+#include "utils/public_image.h"
+#include "utils/voxel_world.h"
+#include "utils/voxel_render.h"
+#include "utils/mesh_voxelizer.h"
+
+#include <omp.h>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+// ============ ПАКЕТНЫЙ РЕНДЕР БЕЗ ОКНА ============
+// Рендерит набор видов того же мира, что и main.cpp, в PNG: файлы камер
+// (Camera::to_file), траекторию (по камере на строку) или облет по кругу.
+// Когда кадров не меньше потоков, параллелятся кадры (каждый кадр со своим
+// буфером рендерится и кодируется в PNG одним потоком), иначе - тайлы
+// внутри кадра, как в интерактивном рендере.
+
+// Вид для рендера: камера и имя выходного файла без расширения
+struct BatchView {
+    Camera camera;
+    std::string name;
+};
+
+static Camera defaultCamera() {
+    // Та же камера, что и в main.cpp
+    Camera camera;
+    camera.pos = float3(0.0f, 50.0f, 100.0f);
+    camera.target = float3(0.0f, 20.0f, 0.0f);
+    camera.up = float3(0.0f, 1.0f, 0.0f);
+    camera.fov_rad = LiteMath::M_PI / 4.0f;
+    camera.z_near = 1.0f;
+    camera.z_far = 300.0f;
+    return camera;
+}
+
+// Облет камеры по умолчанию вокруг ее цели на той же высоте и расстоянии
+static void addOrbit(std::vector<BatchView>& views, int frames) {
+    const Camera base = defaultCamera();
+    const float3 offset = base.pos - base.target;
+    const float radius = sqrtf(offset.x * offset.x + offset.z * offset.z);
+    for (int i = 0; i < frames; i++) {
+        const float angle = 2.0f * LiteMath::M_PI * i / frames;
+        BatchView view{base, "orbit_" + std::to_string(i)};
+        view.camera.pos = base.target + float3(radius * sinf(angle), offset.y, radius * cosf(angle));
+        views.push_back(view);
+    }
+}
+
+// Траектория: по камере на строку, '#' - комментарий,
+//   pos.x pos.y pos.z target.x target.y target.z [fov в градусах]
+static bool addTrajectory(std::vector<BatchView>& views, const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "не удалось открыть траекторию %s\n", path);
+        return false;
+    }
+    const std::string prefix = std::filesystem::path(path).stem().string() + "_";
+    int index = 0;
+    std::string line;
+    for (int lineNo = 1; std::getline(in, line); lineNo++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        BatchView view{defaultCamera(), ""};
+        Camera& c = view.camera;
+        if (!(fields >> c.pos.x)) continue; // пустая строка или комментарий
+        if (!(fields >> c.pos.y >> c.pos.z >> c.target.x >> c.target.y >> c.target.z)) {
+            fprintf(stderr, "%s:%d: неверная камера\n", path, lineNo);
+            continue;
+        }
+        float fovDeg;
+        if (fields >> fovDeg) c.fov_rad = fovDeg * LiteMath::M_PI / 180.0f;
+        view.name = prefix + std::to_string(index++);
+        views.push_back(view);
+    }
+    return true;
+}
+
+static bool addCameraFile(std::vector<BatchView>& views, const char* path) {
+    BatchView view{defaultCamera(), std::filesystem::path(path).stem().string()};
+    if (!view.camera.from_file(path)) return false;
+    views.push_back(view);
+    return true;
+}
+
+// ARGB8 кадр -> RGB в [0, 1], как ждет write_image_rgb
+static void savePNG(const std::string& path, const std::vector<uint32_t>& pixels, int W, int H,
+                    std::vector<float>& rgb) {
+    rgb.resize(3 * W * H);
+    for (int i = 0; i < W * H; i++) {
+        rgb[3 * i + 0] = ((pixels[i] >> 16) & 0xFF) / 255.0f;
+        rgb[3 * i + 1] = ((pixels[i] >> 8) & 0xFF) / 255.0f;
+        rgb[3 * i + 2] = (pixels[i] & 0xFF) / 255.0f;
+    }
+    write_image_rgb(path, rgb, W, H);
+}
+
+static void printUsage() {
+    printf("Использование: batch_render [камеры...] [--cameras <список>] [--trajectory <файл>] [--orbit N]\n"
+           "                            [--out <папка>] [--size WxH] [--octree] [--shadows] [--no-ao]\n"
+           "                            [--no-light] [--no-textures] [--import-obj <файл> [размер]]\n");
+}
+
+int main(int argc, char** args) {
+    std::vector<BatchView> views;
+    std::string outDir = "frames";
+    int W = 640, H = 480;
+    bool useOctree = false, shadows = false, useAO = true, useLight = true, useTextures = true;
+    const char* importObjPath = nullptr;
+    int importResolution = 48;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(args[i], "--orbit") == 0 && i + 1 < argc) {
+            addOrbit(views, std::max(1, atoi(args[++i])));
+        } else if (strcmp(args[i], "--trajectory") == 0 && i + 1 < argc) {
+            if (!addTrajectory(views, args[++i])) return 1;
+        } else if (strcmp(args[i], "--cameras") == 0 && i + 1 < argc) {
+            // Список файлов камер, по пути на строку
+            std::ifstream list(args[++i]);
+            if (!list) {
+                fprintf(stderr, "не удалось открыть список камер %s\n", args[i]);
+                return 1;
+            }
+            std::string path;
+            while (std::getline(list, path))
+                if (!path.empty() && !addCameraFile(views, path.c_str())) return 1;
+        } else if (strcmp(args[i], "--out") == 0 && i + 1 < argc) {
+            outDir = args[++i];
+        } else if (strcmp(args[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(args[++i], "%dx%d", &W, &H) != 2 || W <= 0 || H <= 0) {
+                fprintf(stderr, "неверный размер кадра %s\n", args[i]);
+                return 1;
+            }
+        } else if (strcmp(args[i], "--import-obj") == 0 && i + 1 < argc) {
+            importObjPath = args[++i];
+            if (i + 1 < argc && atoi(args[i + 1]) > 0) {
+                importResolution = atoi(args[++i]);
+            }
+        } else if (strcmp(args[i], "--octree") == 0) {
+            useOctree = true;
+        } else if (strcmp(args[i], "--shadows") == 0) {
+            shadows = true;
+        } else if (strcmp(args[i], "--no-ao") == 0) {
+            useAO = false;
+        } else if (strcmp(args[i], "--no-light") == 0) {
+            useLight = false;
+        } else if (strcmp(args[i], "--no-textures") == 0) {
+            useTextures = false;
+        } else if (args[i][0] == '-') {
+            printUsage();
+            return 1;
+        } else if (!addCameraFile(views, args[i])) {
+            return 1;
+        }
+    }
+    if (views.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    // 1. Мир: тот же ландшафт, что и в main.cpp, с необязательной моделью
+    const int WORLD_SIZE_X = 128;
+    const int WORLD_SIZE_Y = 64;
+    const int WORLD_SIZE_Z = 128;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto gridWorld = std::make_unique<GridVoxelWorld>(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+    TerrainGenerator::createHillyTerrain(*gridWorld);
+    // Материалы - до всего, что строится по миру (свет берет из таблицы излучение)
+    materialTable().load("materials.txt");
+    if (importObjPath) {
+        size_t filled = voxelizeObjIntoWorld(importObjPath, *gridWorld, importResolution,
+                                             int3(WORLD_SIZE_X / 2, 16, WORLD_SIZE_Z / 2));
+        printf("Модель %s: %zu вокселей\n", importObjPath, filled);
+    }
+    std::unique_ptr<OctreeVoxelWorld> octreeWorld;
+    if (useOctree) octreeWorld = std::make_unique<OctreeVoxelWorld>(*gridWorld);
+    const IVoxelWorld& world = useOctree ? (const IVoxelWorld&)*octreeWorld : (const IVoxelWorld&)*gridWorld;
+
+    VoxelOccupancy occupancy;
+    occupancy.build(*gridWorld);
+    VoxelAO ao;
+    if (useAO) ao.build(*gridWorld);
+    VoxelLight light;
+    if (useLight) light.build(*gridWorld);
+
+    TextureAtlas atlas;
+    BlockTextures textures;
+    if (useTextures) {
+        atlas.loadDirectoryCached("textures", "textures.atlas");
+        textures = BlockTextures::bind(atlas);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    printf("%s: подготовка %.1f мс, %zu видов %dx%d -> %s/\n", world.getDescription().c_str(),
+           std::chrono::duration<double, std::milli>(end - start).count(), views.size(), W, H, outDir.c_str());
+
+    DirectedLight sun{LiteMath::normalize(float3(1.0f, 1.0f, 1.0f))};
+    RenderLighting lighting;
+    lighting.sun = shadows ? &sun : nullptr;
+    lighting.ao = useAO ? &ao : nullptr;
+    lighting.light = useLight ? &light : nullptr;
+    RenderSettings settings;
+    settings.occupancy = &occupancy;
+    settings.textures = useTextures ? &textures : nullptr;
+    settings.lighting = &lighting;
+    settings.translucent = true;
+
+    std::error_code error;
+    std::filesystem::create_directories(outDir, error);
+    if (error) {
+        fprintf(stderr, "не удалось создать папку %s: %s\n", outDir.c_str(), error.message().c_str());
+        return 1;
+    }
+
+    // 2. Кадры. Вложенный omp-цикл по тайлам внутри кадра при параллели по
+    // кадрам работает в одном потоке, так что потоки не переподписываются.
+    const int viewCount = (int)views.size();
+    const bool parallelFrames = viewCount >= omp_get_max_threads();
+    start = std::chrono::high_resolution_clock::now();
+    #pragma omp parallel if(parallelFrames)
+    {
+        std::vector<uint32_t> pixels(W * H);
+        std::vector<float> rgb;
+        #pragma omp for schedule(dynamic, 1)
+        for (int i = 0; i < viewCount; i++) {
+            renderVoxelWorld(views[i].camera, world, pixels.data(), W, H, settings);
+            savePNG(outDir + "/" + views[i].name + ".png", pixels, W, H, rgb);
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+
+    const double totalMs = std::chrono::duration<double, std::milli>(end - start).count();
+    printf("Готово: %d кадров за %.1f мс (%.2f мс/кадр, параллельно по %s)\n", viewCount, totalMs,
+           totalMs / viewCount, parallelFrames ? "кадрам" : "тайлам");
+    return 0;
+}
@@ -0,0 +1,936 @@
+#define STB_IMAGE_IMPLEMENTATION
+
+#include "utils/LiteMath.h"
+#include "utils/public_camera.h"
+#include "utils/voxel_world.h"
+#include "utils/voxel_render.h"
+#include "utils/voxel_mesher.h"
+#include "utils/voxel_raster.h"
+#include "utils/mesh_voxelizer.h"
+
+#include <omp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+
+using LiteMath::float3;
+
+// ============ БЕНЧМАРК РЕНДЕРЕРА ============
+static constexpr int BENCH_WIDTH  = 640;
+static constexpr int BENCH_HEIGHT = 480;
+
+// Среднее время кадра в миллисекундах (первый кадр - прогрев, не учитывается)
+template<typename F>
+double measureFrameMs(F&& renderFrame, int frames) {
+    renderFrame();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frames; i++)
+        renderFrame();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / frames;
+}
+
+// Цена функции в кадре: время без нее, с ней и разница в процентах со знаком
+// (отрицательная, если с функцией кадр быстрее)
+static void printFeatureCost(const char* name, const char* without, double withoutMs, const char* with, double withMs) {
+    printf("%-8s %s: %8.2f ms  %s: %8.2f ms (%+.1f%%)\n", name, without, withoutMs, with, withMs,
+           100.0 * (withMs / withoutMs - 1.0));
+}
+
+// Прежний путь для сетки: isSolid/getVoxel/getNormal через vtable на каждом шаге DDA
+struct VirtualStepGridWorld {
+    const IVoxelWorld& world;
+    bool isSolid(int x, int y, int z) const { return world.isSolid(x, y, z); }
+    int getSizeX() const { return world.getSizeX(); }
+    int getSizeZ() const { return world.getSizeZ(); }
+    bool rayCast(const float3& origin, const float3& direction, float maxDist,
+                 float3& hitPos, float3& normal, Voxel& hitVoxel) const {
+        return rayCastGridDDA<IVoxelWorld>(world, origin, direction, maxDist, hitPos, normal, hitVoxel);
+    }
+    bool rayOccluded(const float3& origin, const float3& direction, float maxDist) const {
+        return rayOccludedGridDDA<IVoxelWorld>(world, origin, direction, maxDist);
+    }
+    bool rayCastTranslucent(const float3& origin, const float3& direction, float maxDist,
+                            float3& hitPos, float3& normal, Voxel& hitVoxel, RayMedium& medium) const {
+        return rayCastTranslucentGridDDA<IVoxelWorld>(world, origin, direction, maxDist, hitPos, normal, hitVoxel, medium);
+    }
+};
+
+// Сравнивает обобщенный путь (виртуальный rayCast на каждый пиксель)
+// со специализированным под конкретный тип мира.
+template<class World>
+void benchDevirtualization(const char* name, const World& world, const Camera& camera, int frames) {
+    std::vector<uint32_t> virtualImage(BENCH_WIDTH * BENCH_HEIGHT);
+    std::vector<uint32_t> specializedImage(BENCH_WIDTH * BENCH_HEIGHT);
+
+    const IVoxelWorld& iworld = world;
+    double virtualMs = measureFrameMs([&]() {
+        renderVoxelWorldT<IVoxelWorld>(camera, iworld, virtualImage.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    double specializedMs = measureFrameMs([&]() {
+        renderVoxelWorld(camera, iworld, specializedImage.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+
+    bool same = (virtualImage == specializedImage);
+    printf("%-8s virtual: %8.2f ms  specialized: %8.2f ms  speedup: %.2fx  %s\n",
+           name, virtualMs, specializedMs, virtualMs / specializedMs,
+           same ? "(изображения совпадают)" : "(ИЗОБРАЖЕНИЯ РАЗЛИЧАЮТСЯ)");
+}
+
+// Масштабирование тайлового рендерера по числу потоков
+template<class World>
+void benchThreadScaling(const char* name, const World& world, const Camera& camera, int frames) {
+    std::vector<uint32_t> reference(BENCH_WIDTH * BENCH_HEIGHT);
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    const int maxThreads = omp_get_max_threads();
+
+    double singleMs = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        omp_set_num_threads(threads);
+        double ms = measureFrameMs([&]() {
+            renderVoxelWorld(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+        }, frames);
+        if (threads == 1) {
+            singleMs = ms;
+            reference = image;
+        }
+        printf("%-8s threads: %3d  %8.2f ms  speedup: %.2fx  %s\n", name, threads, ms, singleMs / ms,
+               image == reference ? "(детерминировано)" : "(ИЗОБРАЖЕНИЕ ИЗМЕНИЛОСЬ)");
+        if (threads < maxThreads && threads * 2 > maxThreads)
+            threads = maxThreads / 2; // последним шагом всегда меряем все потоки
+    }
+    omp_set_num_threads(maxThreads);
+}
+
+// Репроецирование при медленном движении камеры: доля полных лучей и время кадра
+template<class World>
+void benchReprojection(const char* name, const World& world, Camera camera, int frames) {
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    ReprojectionCache cache;
+    renderVoxelWorldReprojected(camera, world, cache, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+
+    const float3 step(0.3f, 0.0f, -0.2f);
+    long long traced = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frames; i++) {
+        camera.pos += step;
+        camera.target += step;
+        renderVoxelWorldReprojected(camera, world, cache, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+        traced += cache.tracedRays;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count() / frames;
+    printf("%-8s reprojection: %8.2f ms  полных лучей: %.1f%%\n", name, ms,
+           100.0 * traced / ((double)frames * BENCH_WIDTH * BENCH_HEIGHT));
+}
+
+// Шахматный рендер против полного: время кадра и средняя ошибка на канал
+template<class World>
+void benchCheckerboard(const char* name, const World& world, Camera camera, int frames) {
+    std::vector<uint32_t> reference(BENCH_WIDTH * BENCH_HEIGHT);
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    CheckerboardState state;
+    renderVoxelWorldCheckerboard(camera, world, state, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+
+    const float3 step(0.3f, 0.0f, -0.2f);
+    double ms = 0.0, error = 0.0;
+    for (int i = 0; i < frames; i++) {
+        camera.pos += step;
+        camera.target += step;
+        auto start = std::chrono::high_resolution_clock::now();
+        renderVoxelWorldCheckerboard(camera, world, state, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+        auto end = std::chrono::high_resolution_clock::now();
+        ms += std::chrono::duration<double, std::milli>(end - start).count();
+
+        renderVoxelWorld(camera, world, reference.data(), BENCH_WIDTH, BENCH_HEIGHT);
+        for (size_t p = 0; p < image.size(); p++)
+            for (int shift = 0; shift < 24; shift += 8)
+                error += abs((int)((image[p] >> shift) & 0xFF) - (int)((reference[p] >> shift) & 0xFF));
+    }
+    printf("%-8s checkerboard: %8.2f ms  средняя ошибка: %.3f / 255\n", name, ms / frames,
+           error / ((double)frames * BENCH_WIDTH * BENCH_HEIGHT * 3));
+}
+
+// Beam-проход: старт лучей с безопасной глубины тайла против старта от камеры
+template<class World>
+void benchBeamPrepass(const char* name, const World& world, const VoxelOccupancy& occupancy,
+                      const Camera& camera, int frames) {
+    std::vector<uint32_t> reference(BENCH_WIDTH * BENCH_HEIGHT);
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    double fullMs = measureFrameMs([&]() {
+        renderVoxelWorld(camera, world, reference.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    double beamMs = measureFrameMs([&]() {
+        renderVoxelWorld(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT, RenderSettings{&occupancy});
+    }, frames);
+    int differentPixels = 0;
+    for (size_t p = 0; p < image.size(); p++)
+        differentPixels += (image[p] != reference[p]);
+    printf("%-8s from camera: %8.2f ms  beam prepass: %8.2f ms  speedup: %.2fx  (отличается пикселей: %d)\n",
+           name, fullMs, beamMs, fullMs / beamMs, differentPixels);
+}
+
+// Растеризация поверхности против трассировки первичных лучей на той же сцене
+template<class World>
+void benchRasterization(const char* name, const World& world, const VoxelOccupancy& occupancy,
+                        const Camera& camera, int frames) {
+    std::vector<uint32_t> reference(BENCH_WIDTH * BENCH_HEIGHT);
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<VoxelChunkMesh> chunks = extractVoxelSurface(world);
+    auto end = std::chrono::high_resolution_clock::now();
+    size_t triangles = 0;
+    for (const VoxelChunkMesh& chunk : chunks) triangles += chunk.mesh.TrianglesNum();
+    printf("%-8s surface: %zu чанков, %zu треугольников, %.2f ms\n", name, chunks.size(), triangles,
+           std::chrono::duration<double, std::milli>(end - start).count());
+
+    RasterState state;
+    double rayMs = measureFrameMs([&]() {
+        renderVoxelWorld(camera, world, reference.data(), BENCH_WIDTH, BENCH_HEIGHT, RenderSettings{&occupancy});
+    }, frames);
+    double rasterMs = measureFrameMs([&]() {
+        renderVoxelWorldRaster(camera, world, chunks, state, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    int differentPixels = 0;
+    for (size_t p = 0; p < image.size(); p++)
+        differentPixels += (image[p] != reference[p]);
+    printf("%-8s ray cast: %8.2f ms  raster: %8.2f ms  speedup: %.2fx  (видимых чанков: %d, треугольников: %d, отличается пикселей: %d)\n",
+           name, rayMs, rasterMs, rayMs / rasterMs, state.visibleChunks, state.rasterTriangles, differentPixels);
+}
+
+// Жадное объединение граней против наивного извлечения: число треугольников и время
+template<class World>
+void benchMeshing(const char* name, const World& world) {
+    auto start = std::chrono::high_resolution_clock::now();
+    cmesh4::SimpleMesh naive = mergeVoxelChunks(extractVoxelSurface(world));
+    auto middle = std::chrono::high_resolution_clock::now();
+    cmesh4::SimpleMesh greedy = mergeVoxelChunks(extractVoxelSurfaceGreedy(world));
+    auto end = std::chrono::high_resolution_clock::now();
+    printf("%-8s naive: %zu треугольников (%.2f ms)  greedy: %zu треугольников (%.2f ms)  меньше в %.1f раз\n",
+           name, naive.TrianglesNum(), std::chrono::duration<double, std::milli>(middle - start).count(),
+           greedy.TrianglesNum(), std::chrono::duration<double, std::milli>(end - middle).count(),
+           (double)naive.TrianglesNum() / std::max<size_t>(1, greedy.TrianglesNum()));
+
+    // Компактное представление greedy-меша: размер и время упаковки/распаковки
+    start = std::chrono::high_resolution_clock::now();
+    cmesh4::CompactMesh compact = cmesh4::CompactMeshFromSimpleMesh(greedy);
+    middle = std::chrono::high_resolution_clock::now();
+    cmesh4::SimpleMesh unpacked = compact.ToSimpleMesh();
+    end = std::chrono::high_resolution_clock::now();
+    printf("%-8s compact: %.1f KB -> %.1f KB (меньше в %.1f раз), упаковка %.2f ms, распаковка %.2f ms, %zu вершин\n",
+           name, greedy.SizeInBytes() / 1024.0, compact.SizeInBytes() / 1024.0,
+           (double)greedy.SizeInBytes() / std::max<size_t>(1, compact.SizeInBytes()),
+           std::chrono::duration<double, std::milli>(middle - start).count(),
+           std::chrono::duration<double, std::milli>(end - middle).count(), unpacked.VerticesNum());
+}
+
+// Вокселизация меша мира обратно в сетку того же размера: время и покрытие
+// поверхности (каждый воксель с открытой гранью должен оказаться заполнен)
+inline void benchVoxelizer(const char* name, const GridVoxelWorld& world) {
+    cmesh4::SimpleMesh mesh = mergeVoxelChunks(extractVoxelSurfaceGreedy(world));
+    GridVoxelWorld voxelized(world.getSizeX(), world.getSizeY(), world.getSizeZ());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t filled = voxelizeMesh(mesh, voxelized, -voxelGridOffset(world), 1.0f);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    int missed = 0;
+    for (int x = 0; x < world.getSizeX(); x++)
+    for (int y = 0; y < world.getSizeY(); y++)
+    for (int z = 0; z < world.getSizeZ(); z++) {
+        if (!world.isSolid(x, y, z) || voxelized.isSolid(x, y, z)) continue;
+        for (const int3& n : VOXEL_FACE_NORMALS) {
+            if (!world.isSolid(x + n.x, y + n.y, z + n.z)) { missed++; break; }
+        }
+    }
+    printf("%-8s voxelizer: %zu треугольников -> %zu клеток за %.2f ms  (пропущено вокселей поверхности: %d)\n",
+           name, mesh.TrianglesNum(), filled, std::chrono::duration<double, std::milli>(end - start).count(), missed);
+}
+
+// BVH по greedy-мешу мира: время построения и трассировка того же рельефа
+// треугольниками вместо DDA (воксельный мир - пустая клетка 1x1x1, чтобы не
+// мерить проход DDA по пустой сетке). Попадания/промахи по пикселям должны
+// совпасть с воксельным рендером.
+inline void benchMeshBVH(const char* name, const GridVoxelWorld& world, const Camera& camera, int frames) {
+    cmesh4::SimpleMesh mesh = mergeVoxelChunks(extractVoxelSurfaceGreedy(world));
+    std::vector<Voxel> materials;
+    for (uint32_t type = 0; type <= 4; type++) materials.push_back(voxelForMaterial(type, {}));
+
+    MeshBVH bvh;
+    auto start = std::chrono::high_resolution_clock::now();
+    bvh.build(mesh, materials);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    GridVoxelWorld emptyWorld(1, 1, 1);
+    std::vector<uint32_t> voxelImage(BENCH_WIDTH * BENCH_HEIGHT), meshImage(BENCH_WIDTH * BENCH_HEIGHT);
+    double voxelMs = measureFrameMs([&]() {
+        renderVoxelWorld(camera, world, voxelImage.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    double meshMs = measureFrameMs([&]() {
+        renderVoxelWorld(camera, emptyWorld, meshImage.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                         RenderSettings{nullptr, &bvh});
+    }, frames);
+    int differ = 0;
+    for (size_t i = 0; i < voxelImage.size(); i++)
+        differ += ((voxelImage[i] & 0xFFFFFF) != 0) != ((meshImage[i] & 0xFFFFFF) != 0);
+    printf("%-8s BVH: %zu треугольников, %zu узлов, глубина %d, %.1f KB, построение %.2f ms  DDA: %8.2f ms  BVH: %8.2f ms"
+           "  (пикселей с разным попаданием: %d)\n",
+           name, bvh.triangleCount(), bvh.nodeCount(), bvh.depth(), bvh.getMemoryUsage() / 1024.0,
+           std::chrono::duration<double, std::milli>(end - start).count(), voxelMs, meshMs, differ);
+}
+
+// Теневые лучи: any-hit rayOccluded против полного rayCast на тех же лучах,
+// затем кадр с солнцем и тенями против кадра без них
+template<class World>
+void benchShadows(const char* name, const World& world, const Camera& camera, int frames) {
+    DirectedLight sun;
+    sun.dir = LiteMath::normalize(float3(1.0f, 1.0f, 1.0f)); // то же направление, что и свет по умолчанию
+
+    // Лучи к солнцу из первичных попаданий кадра
+    const RayGenerator rayGen(camera, BENCH_WIDTH, BENCH_HEIGHT);
+    std::vector<float3> origins;
+    for (int y = 0; y < BENCH_HEIGHT; y++)
+    for (int x = 0; x < BENCH_WIDTH; x++) {
+        const float3 dir = rayGen.pixelDirection(x, y);
+        float3 hitPos, normal;
+        Voxel voxel;
+        if (world.rayCast(rayGen.origin, dir, 1000.0f, hitPos, normal, voxel))
+            origins.push_back(hitPos - dir * SHADOW_RAY_OFFSET);
+    }
+    const int count = (int)origins.size();
+
+    std::vector<uint8_t> occluded(count), closest(count);
+    double anyHitMs = measureFrameMs([&]() {
+        #pragma omp parallel for schedule(dynamic, 256)
+        for (int i = 0; i < count; i++)
+            occluded[i] = world.rayOccluded(origins[i], sun.dir, SHADOW_RAY_DIST);
+    }, frames);
+    double closestHitMs = measureFrameMs([&]() {
+        #pragma omp parallel for schedule(dynamic, 256)
+        for (int i = 0; i < count; i++) {
+            float3 hitPos, normal;
+            Voxel voxel;
+            closest[i] = world.rayCast(origins[i], sun.dir, SHADOW_RAY_DIST, hitPos, normal, voxel);
+        }
+    }, frames);
+    int shadowed = 0, mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        shadowed += occluded[i];
+        mismatches += (occluded[i] != closest[i]);
+    }
+
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    double noSunMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    RenderLighting lighting;
+    lighting.sun = &sun;
+    double sunMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                          RenderSettings{nullptr, nullptr, nullptr, &lighting});
+    }, frames);
+    printf("%-8s shadow rays: %d лучей, в тени %.1f%%  rayCast: %8.2f ms  rayOccluded: %8.2f ms  speedup: %.2fx  (расхождений: %d)\n",
+           name, count, 100.0 * shadowed / std::max(count, 1), closestHitMs, anyHitMs, closestHitMs / anyHitMs, mismatches);
+    printFeatureCost(name, "без теней", noSunMs, "с тенями", sunMs);
+}
+
+// Прежний путь сквозь воду: новый rayCast с точки выхода из каждого
+// полупрозрачного вокселя, каждый раз с поиском от корня/входа в сетку
+template<class World>
+bool rayCastRestarting(const World& world, const float3& origin, const float3& dir, float maxDist,
+                       float3& hitPos, float3& normal, Voxel& hitVoxel, RayMedium& medium) {
+    float3 o = origin;
+    while (maxDist > 0.0f && world.rayCast(o, dir, maxDist, hitPos, normal, hitVoxel)) {
+        const MaterialInfo& material = materialTable()[hitVoxel.type];
+        if (!material.transparent()) return true;
+        const int3 cell = hitVoxelCell(world, hitPos, dir);
+        const float3 g = hitPos + voxelGridOffset(world);
+        float tExit = FLT_MAX;
+        for (int i = 0; i < 3; i++)
+            if (dir[i] != 0) tExit = std::min(tExit, ((cell[i] + (dir[i] > 0 ? 1 : 0)) - g[i]) / dir[i]);
+        medium.absorb(material.albedo, hitVoxel.density, tExit);
+        if (medium.saturated()) return false;
+        maxDist -= LiteMath::length(hitPos - o) + tExit;
+        o = hitPos + dir * (tExit + 1e-4f);
+    }
+    return false;
+}
+
+// Лучи сквозь воду: один проход rayCastTranslucent против перезапуска rayCast
+// на каждом полупрозрачном вокселе (на лучах, первым задевающих воду), затем
+// кадр с полупрозрачностью против непрозрачной воды
+template<class World>
+void benchTranslucency(const char* name, const World& world, const Camera& camera, int frames) {
+    const RayGenerator rayGen(camera, BENCH_WIDTH, BENCH_HEIGHT);
+    std::vector<float3> dirs;
+    for (int y = 0; y < BENCH_HEIGHT; y++)
+    for (int x = 0; x < BENCH_WIDTH; x++) {
+        const float3 dir = rayGen.pixelDirection(x, y);
+        float3 hitPos, normal;
+        Voxel voxel;
+        if (world.rayCast(rayGen.origin, dir, 1000.0f, hitPos, normal, voxel) && materialTable()[voxel.type].transparent())
+            dirs.push_back(dir);
+    }
+    const int count = (int)dirs.size();
+
+    // Сравниваются непрозрачные попадания: доля прошедшего света у перезапуска
+    // врет на скользящих лучах, где hitVoxelCell берет пустую клетку под водой
+    std::vector<RayMedium> single(count), restarted(count);
+    std::vector<int> singleHit(count), restartedHit(count);     // тип попадания, -1 - нет
+    double singleMs = measureFrameMs([&]() {
+        #pragma omp parallel for schedule(dynamic, 256)
+        for (int i = 0; i < count; i++) {
+            float3 hitPos, normal;
+            Voxel voxel;
+            single[i] = RayMedium();
+            singleHit[i] = world.rayCastTranslucent(rayGen.origin, dirs[i], 1000.0f, hitPos, normal, voxel, single[i])
+                         ? voxel.type : -1;
+        }
+    }, frames);
+    double restartMs = measureFrameMs([&]() {
+        #pragma omp parallel for schedule(dynamic, 256)
+        for (int i = 0; i < count; i++) {
+            float3 hitPos, normal;
+            Voxel voxel;
+            restarted[i] = RayMedium();
+            restartedHit[i] = rayCastRestarting(world, rayGen.origin, dirs[i], 1000.0f, hitPos, normal, voxel, restarted[i])
+                            ? voxel.type : -1;
+        }
+    }, frames);
+    int saturated = 0, mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        saturated += single[i].saturated();
+        mismatches += singleHit[i] != restartedHit[i];
+    }
+
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    double opaqueMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    double translucentMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                          RenderSettings{nullptr, nullptr, nullptr, nullptr, true});
+    }, frames);
+    printf("%-8s сквозь воду: %d лучей, непрозрачны %.1f%%  перезапуск: %8.2f ms  один проход: %8.2f ms  speedup: %.2fx  (расхождений: %d)\n",
+           name, count, 100.0 * saturated / std::max(count, 1), restartMs, singleMs, restartMs / singleMs, mismatches);
+    printFeatureCost(name, "вода непрозрачна", opaqueMs, "полупрозрачна", translucentMs);
+}
+
+// Запекание AO (угловое и с трассируемым членом), стоимость в кадре и
+// локальный пересчет после правки против полного перезапекания
+void benchAO(const char* name, const GridVoxelWorld& world, const Camera& camera, int frames) {
+    for (bool rayTraced : {false, true}) {
+        VoxelAO ao;
+        auto start = std::chrono::high_resolution_clock::now();
+        ao.build(world, rayTraced);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        // Правка: срываем воксель поверхности в центре мира и ставим камень рядом
+        GridVoxelWorld edited = world;
+        const int cx = world.getSizeX() / 2 + 20, cz = world.getSizeZ() / 2 + 20;
+        int top = world.getSizeY() - 1;
+        while (top > 0 && !world.isSolid(cx, top, cz)) top--;
+        edited.setVoxel(cx, top, cz, VoxelMaterials::createAir());
+        edited.setVoxel(cx + 1, top + 1, cz, VoxelMaterials::createStone());
+        VoxelAO incremental = ao;
+        auto updateStart = std::chrono::high_resolution_clock::now();
+        incremental.update(edited, cx, top, cz);
+        incremental.update(edited, cx + 1, top + 1, cz);
+        auto updateEnd = std::chrono::high_resolution_clock::now();
+        VoxelAO reference;
+        reference.build(edited, rayTraced);
+        int mismatches = 0;
+        for (int x = 0; x < world.getSizeX(); x++)
+        for (int y = 0; y < world.getSizeY(); y++)
+        for (int z = 0; z < world.getSizeZ(); z++)
+            for (int face = 0; face < 6; face++)
+                mismatches += incremental.faceCorners(x, y, z, face) != reference.faceCorners(x, y, z, face);
+
+        printf("%-8s AO %s: запекание %.2f ms, %.1f KB, пересчет правки %.3f ms (расхождений с полным: %d)\n",
+               name, rayTraced ? "угловое + лучи" : "угловое", std::chrono::duration<double, std::milli>(end - start).count(),
+               ao.getMemoryUsage() / 1024.0, std::chrono::duration<double, std::milli>(updateEnd - updateStart).count(),
+               mismatches);
+
+        if (rayTraced) continue;
+        std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+        double plainMs = measureFrameMs([&]() {
+            renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+        }, frames);
+        RenderLighting lighting;
+        lighting.ao = &ao;
+        double aoMs = measureFrameMs([&]() {
+            renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                              RenderSettings{nullptr, nullptr, nullptr, &lighting});
+        }, frames);
+        printFeatureCost(name, "без AO", plainMs, "с AO", aoMs);
+    }
+}
+
+// Свет по вокселям: полный расчет, пересчет правок против полного и цена в кадре
+void benchLight(const char* name, const GridVoxelWorld& world, const Camera& camera, int frames) {
+    VoxelLight light;
+    auto start = std::chrono::high_resolution_clock::now();
+    light.build(world);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // Правки: туннель в склон, светящийся блок в нем, затем его снятие
+    GridVoxelWorld edited = world;
+    VoxelLight incremental = light;
+    const int cx = world.getSizeX() / 2 + 20, cz = world.getSizeZ() / 2 + 20;
+    int top = world.getSizeY() - 1;
+    while (top > 0 && !world.isSolid(cx, top, cz)) top--;
+    int edits = 0;
+    auto edit = [&](int x, int y, int z, const Voxel& voxel) {
+        edited.setVoxel(x, y, z, voxel);
+        incremental.update(edited, x, y, z);
+        edits++;
+    };
+    auto updateStart = std::chrono::high_resolution_clock::now();
+    for (int y = top; y > std::max(top - 8, 1); y--) edit(cx, y, cz, VoxelMaterials::createAir());
+    for (int x = cx + 1; x < cx + 6; x++) edit(x, std::max(top - 7, 2), cz, VoxelMaterials::createAir());
+    edit(cx + 5, std::max(top - 7, 2), cz, VoxelMaterials::createVoxel(5));
+    edit(cx, top, cz, VoxelMaterials::createStone());
+    edit(cx + 5, std::max(top - 7, 2), cz, VoxelMaterials::createAir());
+    auto updateEnd = std::chrono::high_resolution_clock::now();
+
+    VoxelLight reference;
+    reference.build(edited);
+    int mismatches = 0;
+    for (int x = 0; x < world.getSizeX(); x++)
+    for (int y = 0; y < world.getSizeY(); y++)
+    for (int z = 0; z < world.getSizeZ(); z++)
+        for (int channel : {VoxelLight::SKY, VoxelLight::BLOCK})
+            mismatches += incremental.get(x, y, z, channel) != reference.get(x, y, z, channel);
+
+    printf("%-8s свет: расчет %.2f ms, %.1f KB, %d правок за %.3f ms (расхождений с полным: %d)\n",
+           name, std::chrono::duration<double, std::milli>(end - start).count(), light.getMemoryUsage() / 1024.0,
+           edits, std::chrono::duration<double, std::milli>(updateEnd - updateStart).count(), mismatches);
+
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    double plainMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    RenderLighting lighting;
+    lighting.light = &light;
+    double lightMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                          RenderSettings{nullptr, nullptr, nullptr, &lighting});
+    }, frames);
+    printFeatureCost(name, "без света", plainMs, "со светом", lightMs);
+}
+
+// Кэш освещенности: цена обновления при разных разрешениях (бюджет лучей
+// фиксирован), сходимость по кадрам и цена поиска в кадре
+void benchIrradiance(const char* name, const GridVoxelWorld& world, const Camera& camera, int frames) {
+    DirectedLight sun{LiteMath::normalize(float3(1.0f, 1.0f, 1.0f))};
+    RenderLighting lighting;
+    lighting.sun = &sun;
+    
+    for (float scale : {0.5f, 1.0f}) {
+        const int W = (int)(BENCH_WIDTH * scale), H = (int)(BENCH_HEIGHT * scale);
+        IrradianceCache cache;
+        double updateMs = measureFrameMs([&]() {
+            updateIrradianceCacheT(camera, world, cache, W, H, &lighting);
+        }, frames);
+        printf("%-8s кэш освещенности %dx%d: обновление %.2f ms/кадр\n", name, W, H, updateMs);
+    }
+    
+    // Сходимость: средняя по каналам (0..255) разница с эталоном - кадром с
+    // кэшем, накопленным за IRRADIANCE_REFERENCE_FRAMES кадров
+    const int IRRADIANCE_REFERENCE_FRAMES = 512;
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT), reference(image.size());
+    IrradianceCache cache;
+    RenderLighting cached = lighting;
+    cached.irradiance = &cache;
+    for (int frame = 0; frame < IRRADIANCE_REFERENCE_FRAMES; frame++)
+        updateIrradianceCacheT(camera, world, cache, BENCH_WIDTH, BENCH_HEIGHT, &lighting);
+    renderVoxelWorldT(camera, world, reference.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                      RenderSettings{nullptr, nullptr, nullptr, &cached});
+    
+    cache.clear();
+    for (int frame = 1; frame <= 128; frame++) {
+        updateIrradianceCacheT(camera, world, cache, BENCH_WIDTH, BENCH_HEIGHT, &lighting);
+        if ((frame & (frame - 1)) != 0) continue;
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                          RenderSettings{nullptr, nullptr, nullptr, &cached});
+        double diff = 0.0;
+        for (size_t i = 0; i < image.size(); i++)
+            for (int shift = 0; shift < 24; shift += 8)
+                diff += abs((int)((image[i] >> shift) & 0xFF) - (int)((reference[i] >> shift) & 0xFF));
+        printf("%-8s кэш после %3d кадров: %d граней, разница с эталоном (%d кадров) %.3f\n",
+               name, frame, cache.size(), IRRADIANCE_REFERENCE_FRAMES, diff / (image.size() * 3));
+    }
+    printf("%-8s кэш: %.1f KB\n", name, cache.getMemoryUsage() / 1024.0);
+    
+    double plainMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                          RenderSettings{nullptr, nullptr, nullptr, &lighting});
+    }, frames);
+    double cachedMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                          RenderSettings{nullptr, nullptr, nullptr, &cached});
+    }, frames);
+    printFeatureCost(name, "без кэша", plainMs, "с кэшем", cachedMs);
+}
+
+// Текстурированный рендер против плоских цветов вокселей
+template<class World>
+void benchTextures(const char* name, const World& world, const Camera& camera, int frames) {
+    TextureAtlas atlas;
+    auto start = std::chrono::high_resolution_clock::now();
+    atlas.loadDirectory("textures");
+    auto end = std::chrono::high_resolution_clock::now();
+    if (atlas.empty()) {
+        printf("%-8s textures: каталог textures/ не найден\n", name);
+        return;
+    }
+
+    // Запуск без кэша (декодирование + запись кэша) и с кэшем (отображение в память)
+    const std::string cachePath = "bench_textures.atlas";
+    std::remove(cachePath.c_str());
+    auto coldStart = std::chrono::high_resolution_clock::now();
+    TextureAtlas cold;
+    cold.loadDirectoryCached("textures", cachePath);
+    auto coldEnd = std::chrono::high_resolution_clock::now();
+    TextureAtlas warm;
+    warm.loadDirectoryCached("textures", cachePath);
+    auto warmEnd = std::chrono::high_resolution_clock::now();
+    std::remove(cachePath.c_str());
+    printf("%-8s texture cache: без кэша %.2f ms, из кэша %.2f ms (%s)\n", name,
+           std::chrono::duration<double, std::milli>(coldEnd - coldStart).count(),
+           std::chrono::duration<double, std::milli>(warmEnd - coldEnd).count(),
+           warm.fromCache() ? "mmap" : "кэш не принят");
+    const BlockTextures textures = BlockTextures::bind(atlas);
+
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    double flatMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    double texturedMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                          RenderSettings{nullptr, nullptr, &textures});
+    }, frames);
+    printf("%-8s textures: %d текстур %dx%d, %d мипов, %.1f KB, загрузка %.2f ms\n",
+           name, atlas.textureCount(), atlas.tileSize(), atlas.tileSize(), atlas.levels(),
+           atlas.getMemoryUsage() / 1024.0, std::chrono::duration<double, std::milli>(end - start).count());
+    printFeatureCost(name, "плоские", flatMs, "текстуры", texturedMs);
+}
+
+// ============ ТРАЕКТОРИИ КАМЕРЫ ============
+// Детерминированный прогон: фиксированная сцена, фиксированные пути камеры,
+// по каждому бэкенду IVoxelWorld - перцентили времени кадра, лучи в секунду,
+// время построения и память. Результат - таблица в stdout и по желанию
+// JSON/CSV для сравнения между коммитами и машинами.
+static constexpr int TRAJECTORY_FRAMES = 60;
+
+struct CameraPath {
+    const char* name;
+    std::vector<Camera> cameras;
+};
+
+// Высота поверхности столбца мировых координат (x, z), 0 - если столбец пуст
+static float surfaceHeight(const GridVoxelWorld& world, float x, float z) {
+    const int gx = std::clamp((int)floorf(x) + world.getSizeX() / 2, 0, world.getSizeX() - 1);
+    const int gz = std::clamp((int)floorf(z) + world.getSizeZ() / 2, 0, world.getSizeZ() - 1);
+    for (int y = world.getSizeY() - 1; y >= 0; y--)
+        if (world.isSolid(gx, y, gz)) return (float)(y + 1);
+    return 0.0f;
+}
+
+// Облет, пролет над холмами, проход у земли и вид сверху; все пути зависят
+// только от сцены и числа кадров
+static std::vector<CameraPath> makeCameraPaths(const GridVoxelWorld& world, const Camera& base, int frames) {
+    std::vector<CameraPath> paths = {{"orbit", {}}, {"flythrough", {}}, {"ground", {}}, {"topdown", {}}};
+    const float halfX = world.getSizeX() * 0.5f, halfZ = world.getSizeZ() * 0.5f;
+    const float3 offset = base.pos - base.target;
+    const float radius = sqrtf(offset.x * offset.x + offset.z * offset.z);
+    for (int i = 0; i < frames; i++) {
+        const float t = (float)i / frames;
+
+        Camera orbit = base;
+        const float angle = 2.0f * LiteMath::M_PI * t;
+        orbit.pos = base.target + float3(radius * sinf(angle), offset.y, radius * cosf(angle));
+        paths[0].cameras.push_back(orbit);
+
+        // По диагонали мира на высоте над холмами, взгляд вперед и чуть вниз
+        Camera fly = base;
+        const float3 from(-halfX * 0.9f, 36.0f, -halfZ * 0.9f), to(halfX * 0.9f, 30.0f, halfZ * 0.9f);
+        fly.pos = from + (to - from) * t;
+        fly.target = fly.pos + LiteMath::normalize(to - from) * 20.0f - float3(0.0f, 4.0f, 0.0f);
+        paths[1].cameras.push_back(fly);
+
+        // Змейкой в паре вокселей над поверхностью
+        Camera ground = base;
+        auto groundPoint = [&](float s) {
+            const float x = -halfX * 0.8f + 1.6f * halfX * s;
+            const float z = halfZ * 0.3f * sinf(2.0f * LiteMath::M_PI * s);
+            return float3(x, surfaceHeight(world, x, z) + 2.5f, z);
+        };
+        ground.pos = groundPoint(t);
+        const float3 ahead = groundPoint(t + 0.05f);
+        ground.target = float3(ahead.x, ground.pos.y, ahead.z);
+        paths[2].cameras.push_back(ground);
+
+        // Сверху вниз, смещаясь вдоль x
+        Camera top = base;
+        top.pos = float3(-halfX * 0.5f + halfX * t, 120.0f, 0.0f);
+        top.target = top.pos - float3(0.0f, 120.0f, 0.0f);
+        top.up = float3(0.0f, 0.0f, -1.0f);
+        paths[3].cameras.push_back(top);
+    }
+    return paths;
+}
+
+struct PathStats {
+    std::string path;
+    int frames = 0;
+    double meanMs = 0.0, minMs = 0.0, p50Ms = 0.0, p90Ms = 0.0, p99Ms = 0.0, maxMs = 0.0;
+    double raysPerSec = 0.0;   // первичные лучи: пиксель на кадр
+    uint64_t checksum = 0;     // хеш всех кадров пути
+};
+
+struct BackendStats {
+    std::string name, description;
+    double buildMs = 0.0;      // построение бэкенда из готовой сетки, без генерации ландшафта
+    size_t memoryBytes = 0;
+    std::vector<PathStats> paths;
+};
+
+// Перцентиль по ближайшему рангу, times отсортированы
+static double percentile(const std::vector<double>& times, double p) {
+    const int rank = (int)ceil(p / 100.0 * times.size());
+    return times[std::clamp(rank - 1, 0, (int)times.size() - 1)];
+}
+
+static PathStats runCameraPath(const IVoxelWorld& world, const CameraPath& path, const VoxelOccupancy& occupancy,
+                               const RenderLighting& lighting, std::vector<uint32_t>& image) {
+    PathStats stats;
+    stats.path = path.name;
+    stats.frames = (int)path.cameras.size();
+    stats.checksum = hashBytes(nullptr, 0);
+    auto render = [&](const Camera& camera) {
+        renderVoxelWorld(camera, world, image.data(), BENCH_WIDTH, BENCH_HEIGHT,
+                         RenderSettings{&occupancy, nullptr, nullptr, &lighting, true});
+    };
+    render(path.cameras[0]); // прогрев
+
+    std::vector<double> times;
+    for (const Camera& camera : path.cameras) {
+        auto start = std::chrono::high_resolution_clock::now();
+        render(camera);
+        auto end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        stats.checksum = hashBytes(image.data(), image.size() * sizeof(uint32_t), stats.checksum);
+    }
+    double total = 0.0;
+    for (double t : times) total += t;
+    std::sort(times.begin(), times.end());
+    stats.meanMs = total / times.size();
+    stats.minMs = times.front();
+    stats.maxMs = times.back();
+    stats.p50Ms = percentile(times, 50.0);
+    stats.p90Ms = percentile(times, 90.0);
+    stats.p99Ms = percentile(times, 99.0);
+    stats.raysPerSec = (double)BENCH_WIDTH * BENCH_HEIGHT * times.size() / (total / 1000.0);
+    return stats;
+}
+
+static bool writeTrajectoryJSON(const char* file, const std::vector<BackendStats>& backends, int frames,
+                                double generationMs) {
+    FILE* f = fopen(file, "w");
+    if (!f) {
+        fprintf(stderr, "не удалось открыть %s\n", file);
+        return false;
+    }
+    fprintf(f, "{\n  \"width\": %d,\n  \"height\": %d,\n  \"threads\": %d,\n  \"frames_per_path\": %d,\n",
+            BENCH_WIDTH, BENCH_HEIGHT, omp_get_max_threads(), frames);
+    fprintf(f, "  \"generation_ms\": %.3f,\n", generationMs);
+    fprintf(f, "  \"backends\": [\n");
+    for (size_t b = 0; b < backends.size(); b++) {
+        const BackendStats& backend = backends[b];
+        fprintf(f, "    {\n      \"name\": \"%s\",\n      \"description\": \"%s\",\n", backend.name.c_str(),
+                backend.description.c_str());
+        fprintf(f, "      \"build_ms\": %.3f,\n      \"memory_bytes\": %zu,\n      \"paths\": [\n",
+                backend.buildMs, backend.memoryBytes);
+        for (size_t p = 0; p < backend.paths.size(); p++) {
+            const PathStats& s = backend.paths[p];
+            fprintf(f, "        {\"path\": \"%s\", \"frames\": %d, \"mean_ms\": %.3f, \"min_ms\": %.3f, "
+                       "\"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f, "
+                       "\"rays_per_s\": %.0f, \"checksum\": \"%016llx\"}%s\n",
+                    s.path.c_str(), s.frames, s.meanMs, s.minMs, s.p50Ms, s.p90Ms, s.p99Ms, s.maxMs, s.raysPerSec,
+                    (unsigned long long)s.checksum, p + 1 < backend.paths.size() ? "," : "");
+        }
+        fprintf(f, "      ]\n    }%s\n", b + 1 < backends.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+static bool writeTrajectoryCSV(const char* file, const std::vector<BackendStats>& backends, double generationMs) {
+    FILE* f = fopen(file, "w");
+    if (!f) {
+        fprintf(stderr, "не удалось открыть %s\n", file);
+        return false;
+    }
+    fprintf(f, "backend,path,frames,mean_ms,min_ms,p50_ms,p90_ms,p99_ms,max_ms,rays_per_s,generation_ms,build_ms,memory_bytes,checksum\n");
+    for (const BackendStats& backend : backends)
+        for (const PathStats& s : backend.paths)
+            fprintf(f, "%s,%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.0f,%.3f,%.3f,%zu,%016llx\n", backend.name.c_str(),
+                    s.path.c_str(), s.frames, s.meanMs, s.minMs, s.p50Ms, s.p90Ms, s.p99Ms, s.maxMs, s.raysPerSec,
+                    generationMs, backend.buildMs, backend.memoryBytes, (unsigned long long)s.checksum);
+    fclose(f);
+    return true;
+}
+
+//   bench --trajectories [--frames N] [--json <файл>] [--csv <файл>]
+static int runTrajectories(int argc, char** argv, const Camera& base) {
+    int frames = TRAJECTORY_FRAMES;
+    const char* jsonPath = nullptr;
+    const char* csvPath = nullptr;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else {
+            fprintf(stderr, "Использование: bench --trajectories [--frames N] [--json <файл>] [--csv <файл>]\n");
+            return 1;
+        }
+    }
+
+    // Та же сцена, что и в main.cpp. Генерация ландшафта меряется отдельно, а каждый
+    // бэкенд строится из одной и той же готовой сетки: сетка - копированием вокселей,
+    // октодерево - своим конструктором
+    auto start = std::chrono::high_resolution_clock::now();
+    GridVoxelWorld source(128, 64, 128);
+    TerrainGenerator::createHillyTerrain(source);
+    auto end = std::chrono::high_resolution_clock::now();
+    const double generationMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    auto gridWorld = std::make_unique<GridVoxelWorld>(source.getSizeX(), source.getSizeY(), source.getSizeZ());
+    for (int x = 0; x < source.getSizeX(); x++)
+        for (int y = 0; y < source.getSizeY(); y++)
+            for (int z = 0; z < source.getSizeZ(); z++)
+                gridWorld->setVoxel(x, y, z, source.getVoxel(x, y, z));
+    end = std::chrono::high_resolution_clock::now();
+    const double gridBuildMs = std::chrono::duration<double, std::milli>(end - start).count();
+    start = std::chrono::high_resolution_clock::now();
+    auto octreeWorld = std::make_unique<OctreeVoxelWorld>(source);
+    end = std::chrono::high_resolution_clock::now();
+    const double octreeBuildMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    VoxelOccupancy occupancy;
+    occupancy.build(source);
+    VoxelAO ao;
+    ao.build(source);
+    VoxelLight light;
+    light.build(source);
+    RenderLighting lighting;
+    lighting.ao = &ao;
+    lighting.light = &light;
+
+    const std::vector<CameraPath> paths = makeCameraPaths(source, base, frames);
+    struct Backend { const char* name; const IVoxelWorld& world; double buildMs; };
+    const Backend worlds[] = {{"Grid", *gridWorld, gridBuildMs}, {"Octree", *octreeWorld, octreeBuildMs}};
+
+    printf("=== Траектории: %dx%d, %d кадров на путь, %d потоков ===\n", BENCH_WIDTH, BENCH_HEIGHT, frames,
+           omp_get_max_threads());
+    printf("Генерация ландшафта %.2f ms\n", generationMs);
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    std::vector<BackendStats> results;
+    for (const Backend& backend : worlds) {
+        BackendStats stats;
+        stats.name = backend.name;
+        stats.description = backend.world.getDescription();
+        stats.buildMs = backend.buildMs;
+        stats.memoryBytes = backend.world.getMemoryUsage();
+        printf("%-8s построение %.2f ms, %.2f MB\n", backend.name, stats.buildMs, stats.memoryBytes / (1024.0 * 1024.0));
+        for (const CameraPath& path : paths) {
+            stats.paths.push_back(runCameraPath(backend.world, path, occupancy, lighting, image));
+            const PathStats& s = stats.paths.back();
+            printf("%-8s %-10s mean %7.2f  p50 %7.2f  p90 %7.2f  p99 %7.2f  max %7.2f ms  %6.2f Mray/s  %016llx\n",
+                   backend.name, s.path.c_str(), s.meanMs, s.p50Ms, s.p90Ms, s.p99Ms, s.maxMs, s.raysPerSec / 1e6,
+                   (unsigned long long)s.checksum);
+        }
+        results.push_back(stats);
+    }
+
+    if (jsonPath && !writeTrajectoryJSON(jsonPath, results, frames, generationMs)) return 1;
+    if (csvPath && !writeTrajectoryCSV(csvPath, results, generationMs)) return 1;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    // Та же камера, что и в main.cpp
+    Camera camera;
+    camera.pos = float3(0.0f, 50.0f, 100.0f);
+    camera.target = float3(0.0f, 20.0f, 0.0f);
+    camera.up = float3(0.0f, 1.0f, 0.0f);
+    camera.fov_rad = LiteMath::M_PI / 4.0f;
+    camera.z_near = 1.0f;
+    camera.z_far = 300.0f;
+
+    if (argc > 1 && strcmp(argv[1], "--trajectories") == 0)
+        return runTrajectories(argc - 2, argv + 2, camera);
+    int frames = (argc > 1) ? std::max(1, atoi(argv[1])) : 5;
+
+    const int WORLD_SIZE_X = 128;
+    const int WORLD_SIZE_Y = 64;
+    const int WORLD_SIZE_Z = 128;
+
+    auto gridWorld = std::make_unique<GridVoxelWorld>(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+    TerrainGenerator::createHillyTerrain(*gridWorld);
+    auto octreeWorld = std::make_unique<OctreeVoxelWorld>(*gridWorld);
+
+    printf("=== Бенчмарк рендерера: %dx%d, %d кадров ===\n", BENCH_WIDTH, BENCH_HEIGHT, frames);
+    printf("Память: Grid %.2f MB, Octree %.2f MB, воксель %zu B, таблица материалов %zu B\n",
+           gridWorld->getMemoryUsage() / (1024.0 * 1024.0), octreeWorld->getMemoryUsage() / (1024.0 * 1024.0),
+           sizeof(Voxel), materialTable().getMemoryUsage());
+    benchDevirtualization("Grid", *gridWorld, camera, frames);
+    benchDevirtualization("Octree", *octreeWorld, camera, frames);
+
+    std::vector<uint32_t> image(BENCH_WIDTH * BENCH_HEIGHT);
+    VirtualStepGridWorld virtualStepGrid{*gridWorld};
+    double virtualStepMs = measureFrameMs([&]() {
+        renderVoxelWorldT(camera, virtualStepGrid, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    double specializedMs = measureFrameMs([&]() {
+        renderVoxelWorld(camera, *gridWorld, image.data(), BENCH_WIDTH, BENCH_HEIGHT);
+    }, frames);
+    printf("Grid     virtual per DDA step: %8.2f ms  specialized: %8.2f ms  speedup: %.2fx\n",
+           virtualStepMs, specializedMs, virtualStepMs / specializedMs);
+
+    benchThreadScaling("Grid", *gridWorld, camera, frames);
+    benchReprojection("Grid", *gridWorld, camera, frames);
+    benchCheckerboard("Grid", *gridWorld, camera, frames);
+
+    VoxelOccupancy occupancy;
+    occupancy.build(*gridWorld);
+    benchBeamPrepass("Grid", *gridWorld, occupancy, camera, frames);
+    benchBeamPrepass("Octree", *octreeWorld, occupancy, camera, frames);
+    benchRasterization("Grid", *gridWorld, occupancy, camera, frames);
+    benchMeshing("Grid", *gridWorld);
+    benchMeshing("Octree", *octreeWorld);
+    benchVoxelizer("Grid", *gridWorld);
+    benchMeshBVH("Grid", *gridWorld, camera, frames);
+    benchTextures("Grid", *gridWorld, camera, frames);
+    benchShadows("Grid", *gridWorld, camera, frames);
+    benchShadows("Octree", *octreeWorld, camera, frames);
+    benchTranslucency("Grid", *gridWorld, camera, frames);
+    benchTranslucency("Octree", *octreeWorld, camera, frames);
+    benchAO("Grid", *gridWorld, camera, frames);
+    benchLight("Grid", *gridWorld, camera, frames);
+    benchIrradiance("Grid", *gridWorld, camera, frames);
+    return 0;
+}
@@ -5,9 +5,16 @@
 #include "utils/LiteMath.h"
 #include "utils/public_camera.h"
 #include "utils/public_image.h"
+#include "utils/voxel_world.h"
+#include "utils/voxel_render.h"
+#include "utils/voxel_mesher.h"
+#include "utils/voxel_raster.h"
+#include "utils/mesh_voxelizer.h"
+#include "utils/mesh_bvh.h"
 
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
 #include <SDL_keycode.h>
 #include <cstdint>
 #include <iostream>
@@ -31,672 +38,152 @@ using LiteMath::uint2;
 using LiteMath::uint3;
 using LiteMath::uint4;
 
-// ============ ВОКСЕЛЬНЫЙ ИНТЕРФЕЙС ============
+// ============ ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ ============
+std::unique_ptr<IVoxelWorld> g_voxelWorld;
+VoxelOccupancy g_occupancy;          // грубая карта занятости для beam-прохода
+bool g_beamPrepassEnabled = true;
+std::vector<VoxelChunkMesh> g_surfaceChunks; // видимые грани по чанкам для растеризации
+RasterState g_rasterState;
+MeshBVH g_meshBVH;                   // меши сцены, трассируются вместе с вокселями
+TextureAtlas g_textureAtlas;         // текстуры блоков из textures/
+BlockTextures g_blockTextures;
+bool g_texturesEnabled = true;
+DirectedLight g_sun{LiteMath::normalize(float3(1.0f, 1.0f, 1.0f))}; // солнце для теней
+bool g_shadowsEnabled = false;
+VoxelAO g_ao;                        // запеченное затенение граней
+bool g_aoEnabled = true;
+VoxelLight g_light;                  // свет неба и излучающих блоков по вокселям
+bool g_lightEnabled = true;
+IrradianceCache g_irradiance;        // накопленный рассеянный свет граней
+bool g_irradianceEnabled = false;
+bool g_translucentEnabled = true;    // лучи проходят воду насквозь
 
-// 1. Структура вокселя с материалами
-struct Voxel {
-    uint32_t type;        // тип материала: 0=air, 1=grass, 2=dirt, 3=stone, 4=water
-    uint32_t color;       // цвет в формате RGBA
-    float3 normal;        // нормаль
-    uint8_t density;      // плотность
-    uint8_t metadata;     // дополнительные данные
-    
-    Voxel() : type(0), color(0xFF000000), normal(0,0,0), density(0), metadata(0) {}
-    
-    // Простой конструктор
-    Voxel(uint32_t t, uint32_t c) : type(t), color(c), normal(0,0,0), density(0), metadata(0) {}
-};
+// ============ РАЗРЕШЕНИЕ ЭКРАНА ============
+static constexpr int SCREEN_WIDTH  = 640;
+static constexpr int SCREEN_HEIGHT = 480;
 
-// 2. Абстрактный интерфейс для воксельного мира
-class IVoxelWorld {
-public:
-    virtual ~IVoxelWorld() = default;
-    
-    // Основные методы доступа
-    virtual Voxel getVoxel(int x, int y, int z) const = 0;
-    virtual bool isSolid(int x, int y, int z) const = 0;
-    virtual float3 getNormal(int x, int y, int z) const = 0;
-    
-    // Информация о размерах
-    virtual int getSizeX() const = 0;
-    virtual int getSizeY() const = 0;
-    virtual int getSizeZ() const = 0;
-    
-    // Для отладки и оптимизации
-    virtual size_t getMemoryUsage() const = 0;
-    virtual std::string getDescription() const = 0;
-    
-    // Метод для трассировки лучей
-    virtual bool rayCast(const float3& origin, const float3& direction,
-                        float maxDist, float3& hitPos, float3& normal,
-                        Voxel& hitVoxel) const = 0;
+// ============ ДИНАМИЧЕСКОЕ РАЗРЕШЕНИЕ ============
+bool g_dynamicResolutionEnabled = false;
+DynamicResolution g_dynamicResolution;
+std::vector<uint32_t> g_renderPixels; // буфер внутреннего разрешения
+
+// ============ РЕЖИМЫ РЕНДЕРА ============
+enum class RenderMode : uint8_t {
+    FULL,           // все пиксели каждый кадр
+    REPROJECT,      // репроецирование попаданий прошлого кадра
+    PROGRESSIVE,    // разреженная трассировка в движении, уточнение после остановки
+    CHECKERBOARD,   // половина пикселей в шахматном порядке + восстановление
+    RASTER          // первичная видимость растеризацией граней
 };
 
-// 3. Реализация на основе регулярной сетки
-class GridVoxelWorld : public IVoxelWorld {
-private:
-    std::vector<std::vector<std::vector<Voxel>>> grid;
-    int sizeX, sizeY, sizeZ;
-    
-public:
-    GridVoxelWorld(int sx, int sy, int sz) : sizeX(sx), sizeY(sy), sizeZ(sz) {
-        grid.resize(sizeX);
-        for (int x = 0; x < sizeX; x++) {
-            grid[x].resize(sizeY);
-            for (int y = 0; y < sizeY; y++) {
-                grid[x][y].resize(sizeZ);
-                // Инициализируем все как воздух
-                for (int z = 0; z < sizeZ; z++) {
-                    grid[x][y][z] = Voxel(0, 0xFF000000);
-                }
-            }
-        }
-    }
-    
-    // Установка вокселя (для генерации ландшафта)
-    void setVoxel(int x, int y, int z, const Voxel& voxel) {
-        if (x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ) {
-            grid[x][y][z] = voxel;
-        }
-    }
-    
-    // Реализация интерфейса
-    Voxel getVoxel(int x, int y, int z) const override {
-        if (x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ) {
-            return grid[x][y][z];
-        }
-        return Voxel(0, 0xFF000000); // Возвращаем воздух вне границ
-    }
-    
-    bool isSolid(int x, int y, int z) const override {
-        if (x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ) {
-            return grid[x][y][z].type != 0; // 0 = воздух
-        }
-        return false;
-    }
-    
-    float3 getNormal(int x, int y, int z) const override {
-        // Вычисляем нормаль по соседям
-        float3 normal(0.0f, 0.0f, 0.0f);
-        
-        if (x > 0 && !isSolid(x-1, y, z)) normal.x = -1.0f;
-        else if (x < sizeX-1 && !isSolid(x+1, y, z)) normal.x = 1.0f;
-        
-        if (y > 0 && !isSolid(x, y-1, z)) normal.y = -1.0f;
-        else if (y < sizeY-1 && !isSolid(x, y+1, z)) normal.y = 1.0f;
-        
-        if (z > 0 && !isSolid(x, y, z-1)) normal.z = -1.0f;
-        else if (z < sizeZ-1 && !isSolid(x, y, z+1)) normal.z = 1.0f;
-        
-        if (LiteMath::length(normal) < 0.1f) {
-            return float3(0.0f, 1.0f, 0.0f);
-        }
-        
-        return LiteMath::normalize(normal);
-    }
-    
-    bool rayCast(const float3& origin, const float3& direction,
-                float maxDist, float3& hitPos, float3& normal,
-                Voxel& hitVoxel) const override {
-        
-        // Преобразуем мировые координаты в координаты сетки
-        float3 gridOrigin = origin + float3(sizeX/2.0f, 0, sizeZ/2.0f);
-        float3 rayStart = gridOrigin;
-        float3 dir = LiteMath::normalize(direction);
-        float3 pos = rayStart;
-        
-        // Определяем текущий воксель
-        int x = static_cast<int>(floor(pos.x));
-        int y = static_cast<int>(floor(pos.y));
-        int z = static_cast<int>(floor(pos.z));
-        
-        // Проверяем, находимся ли мы внутри сетки
-        if (x < 0 || x >= sizeX || y < 0 || y >= sizeY || z < 0 || z >= sizeZ) {
-            // Находим точку входа в сетку
-            float tMin = 0.0f;
-            float tMax = maxDist;
-            
-            for (int i = 0; i < 3; i++) {
-                if (dir[i] != 0) {
-                    float t1 = (0 - pos[i]) / dir[i];
-                    float t2 = ((i == 0 ? sizeX : (i == 1 ? sizeY : sizeZ)) - 1 - pos[i]) / dir[i];
-                    float tNear = std::min(t1, t2);
-                    float tFar = std::max(t1, t2);
-                    
-                    tMin = std::max(tMin, tNear);
-                    tMax = std::min(tMax, tFar);
-                    
-                    if (tMin > tMax) return false;
-                }
-            }
-            
-            if (tMin > 0) {
-                pos = pos + dir * tMin;
-                x = static_cast<int>(floor(pos.x));
-                y = static_cast<int>(floor(pos.y));
-                z = static_cast<int>(floor(pos.z));
-            } else {
-                return false;
-            }
-        }
-        
-        // Шаги по осям
-        int stepX = (dir.x > 0) ? 1 : -1;
-        int stepY = (dir.y > 0) ? 1 : -1;
-        int stepZ = (dir.z > 0) ? 1 : -1;
-        
-        // Расстояние до следующей границы вокселя
-        float nextX = (stepX > 0) ? (x + 1) : x;
-        float nextY = (stepY > 0) ? (y + 1) : y;
-        float nextZ = (stepZ > 0) ? (z + 1) : z;
-        
-        float tMaxX = (dir.x != 0) ? (nextX - pos.x) / dir.x : FLT_MAX;
-        float tMaxY = (dir.y != 0) ? (nextY - pos.y) / dir.y : FLT_MAX;
-        float tMaxZ = (dir.z != 0) ? (nextZ - pos.z) / dir.z : FLT_MAX;
-        
-        // Расстояние для перехода к следующему вокселю
-        float tDeltaX = (dir.x != 0) ? fabs(1.0f / dir.x) : FLT_MAX;
-        float tDeltaY = (dir.y != 0) ? fabs(1.0f / dir.y) : FLT_MAX;
-        float tDeltaZ = (dir.z != 0) ? fabs(1.0f / dir.z) : FLT_MAX;
-        
-        float distance = 0;
-        
-        // Основной цикл DDA
-        while (distance < maxDist) {
-            // Проверяем границы
-            if (x < 0 || x >= sizeX || y < 0 || y >= sizeY || z < 0 || z >= sizeZ) {
-                break;
-            }
-            
-            // Проверяем, попали ли в воксель поверхности
-            if (isSolid(x, y, z)) {
-                hitPos = pos - float3(sizeX/2.0f, 0, sizeZ/2.0f);
-                hitVoxel = getVoxel(x, y, z);
-                normal = getNormal(x, y, z);
-                return true;
-            }
-            
-            // Переход к следующему вокселю
-            if (tMaxX < tMaxY && tMaxX < tMaxZ) {
-                x += stepX;
-                distance = tMaxX;
-                tMaxX += tDeltaX;
-            } else if (tMaxY < tMaxZ) {
-                y += stepY;
-                distance = tMaxY;
-                tMaxY += tDeltaY;
-            } else {
-                z += stepZ;
-                distance = tMaxZ;
-                tMaxZ += tDeltaZ;
-            }
-            
-            // Обновляем позицию
-            pos = rayStart + dir * distance;
-        }
-        
-        return false;
-    }
-    
-    int getSizeX() const override { return sizeX; }
-    int getSizeY() const override { return sizeY; }
-    int getSizeZ() const override { return sizeZ; }
-    
-    size_t getMemoryUsage() const override {
-        return sizeX * sizeY * sizeZ * sizeof(Voxel);
-    }
-    
-    std::string getDescription() const override {
-        return "Grid Voxel World (" + std::to_string(sizeX) + "x" + 
-               std::to_string(sizeY) + "x" + std::to_string(sizeZ) + ")";
-    }
-};
+RenderMode g_renderMode = RenderMode::FULL;
+ReprojectionCache g_reprojectionCache;
+ProgressiveState g_progressiveState;
+CheckerboardState g_checkerboardState;
 
-// 4. Утилиты для материалов и цветов
-namespace VoxelMaterials {
-    // Цвета материалов (в формате ARGB)
-    const uint32_t AIR_COLOR   = 0x00000000;
-    const uint32_t GRASS_COLOR = 0xFF228B22;  // зеленый
-    const uint32_t DIRT_COLOR  = 0xFF8B4513;  // коричневый
-    const uint32_t STONE_COLOR = 0xFF808080;  // серый
-    const uint32_t WATER_COLOR = 0xFF1E90FF;  // голубой
-    
-    Voxel createVoxel(uint32_t type, uint32_t color = 0xFFFFFFFF) {
-        Voxel v;
-        v.type = type;
-        v.color = color;
-        return v;
-    }
-    
-    Voxel createAir() {
-        return createVoxel(0, AIR_COLOR);
-    }
-    
-    Voxel createGrass(float heightRatio = 1.0f) {
-        // Немного варьируем цвет травы в зависимости от высоты
-        uint8_t r = 34;  // 0x22
-        uint8_t g = 139 + static_cast<uint8_t>((heightRatio - 0.5f) * 50); // 0x8B
-        uint8_t b = 34;  // 0x22
-        uint32_t color = 0xFF000000 | (r << 16) | (g << 8) | b;
-        return createVoxel(1, color);
-    }
-    
-    Voxel createDirt() {
-        return createVoxel(2, DIRT_COLOR);
-    }
-    
-    Voxel createStone() {
-        return createVoxel(3, STONE_COLOR);
-    }
-    
-    Voxel createWater() {
-        Voxel v = createVoxel(4, WATER_COLOR);
-        v.density = 100; // Вода имеет плотность
-        return v;
-    }
-    
-    float3 getColorAsFloat3(uint32_t color) {
-        float r = ((color >> 16) & 0xFF) / 255.0f;
-        float g = ((color >> 8) & 0xFF) / 255.0f;
-        float b = (color & 0xFF) / 255.0f;
-        return float3(r, g, b);
+const char* render_mode_name(RenderMode mode) {
+    switch (mode) {
+    case RenderMode::REPROJECT:   return "репроецирование";
+    case RenderMode::PROGRESSIVE: return "прогрессивный";
+    case RenderMode::CHECKERBOARD: return "шахматный";
+    case RenderMode::RASTER:      return "растеризация";
+    default:                      return "полный";
     }
 }
 
-// 5. Генератор ландшафта
-namespace TerrainGenerator {
-    void createHillyTerrain(GridVoxelWorld& world) {
-        int sizeX = world.getSizeX();
-        int sizeY = world.getSizeY();
-        int sizeZ = world.getSizeZ();
-        
-        float baseHeight = sizeY * 0.3f;
-        
-        for (int x = 0; x < sizeX; x++) {
-            for (int z = 0; z < sizeZ; z++) {
-                // Периодическая функция для высоты
-                float fx = sin(x * 0.1f) * 0.7f;
-                float fz = cos(z * 0.08f) * 0.5f;
-                float hills = sin(x * 0.03f + z * 0.05f) * 1.2f;
-                float height = baseHeight + (fx + fz + hills) * 8.0f;
-                
-                int y_height = static_cast<int>(height);
-                y_height = std::clamp(y_height, 0, sizeY - 1);
-                
-                // Заполняем столбец вокселей с разными материалами
-                for (int y = 0; y <= y_height; y++) {
-                    Voxel voxel;
-                    float heightRatio = (float)y / sizeY;
-                    
-                    if (y == y_height) {
-                        // Поверхность - трава
-                        voxel = VoxelMaterials::createGrass(heightRatio);
-                    } else if (y > y_height - 5) {
-                        // Верхний слой - земля
-                        voxel = VoxelMaterials::createDirt();
-                    } else {
-                        // Нижние слои - камень
-                        voxel = VoxelMaterials::createStone();
-                    }
-                    
-                    world.setVoxel(x, y, z, voxel);
-                }
-            }
-        }
-        
-        // Добавляем озеро в центре
-        int centerX = sizeX / 2;
-        int centerZ = sizeZ / 2;
-        int lakeRadius = 15;
-        
-        for (int x = centerX - lakeRadius; x <= centerX + lakeRadius; x++) {
-            for (int z = centerZ - lakeRadius; z <= centerZ + lakeRadius; z++) {
-                float dx = x - centerX;
-                float dz = z - centerZ;
-                float dist = sqrt(dx*dx + dz*dz);
-                
-                if (dist <= lakeRadius) {
-                    // Убираем землю под озером
-                    for (int y = 0; y < 10; y++) {
-                        world.setVoxel(x, y, z, VoxelMaterials::createAir());
-                    }
-                    // Добавляем воду
-                    for (int y = 10; y < 12; y++) {
-                        if (x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ) {
-                            world.setVoxel(x, y, z, VoxelMaterials::createWater());
-                        }
-                    }
-                }
-            }
-        }
-    }
-    
-    void createFlatTerrain(GridVoxelWorld& world, float height = 20.0f) {
-        // Простая плоская местность для тестирования
-        int sizeX = world.getSizeX();
-        int sizeY = world.getSizeY();
-        int sizeZ = world.getSizeZ();
-        
-        int y_height = static_cast<int>(height);
-        y_height = std::clamp(y_height, 0, sizeY - 1);
-        
-        for (int x = 0; x < sizeX; x++) {
-            for (int z = 0; z < sizeZ; z++) {
-                for (int y = 0; y <= y_height; y++) {
-                    Voxel voxel;
-                    if (y == y_height) {
-                        voxel = VoxelMaterials::createGrass(0.5f);
-                    } else {
-                        voxel = VoxelMaterials::createDirt();
-                    }
-                    world.setVoxel(x, y, z, voxel);
-                }
-            }
-        }
-    }
+// Сброс истории кадров: после смены режима или настроек освещения и материалов
+// переиспользованные пиксели прошлых кадров устарели
+void invalidate_history() {
+    g_reprojectionCache.invalidate();
+    g_progressiveState.invalidate();
+    g_checkerboardState.invalidate();
 }
 
-// ============ ОКТОДЕРЕВО =============
-struct OctreeNode {
-    bool isLeaf = true;
-    bool solid = false;      // есть ли хотя бы один solid
-    Voxel voxel;             // если однородный
-    int3 min;                // inclusive
-    int3 max;                // exclusive
-    std::unique_ptr<OctreeNode> children[8];
-};
-
-class OctreeVoxelWorld : public IVoxelWorld {
-public:
-    OctreeVoxelWorld(const GridVoxelWorld& grid) {
-        sizeX = grid.getSizeX();
-        sizeY = grid.getSizeY();
-        sizeZ = grid.getSizeZ();
-        root = buildNode(grid, int3(0,0,0), int3(sizeX, sizeY, sizeZ));
-    }
-
-    // ===== интерфейс =====
-    Voxel getVoxel(int x,int y,int z) const override {
-        return getVoxelNode(root.get(), x,y,z);
-    }
-
-    bool isSolid(int x,int y,int z) const override {
-        return getVoxel(x,y,z).type != 0;
-    }
-
-    float3 getNormal(int x,int y,int z) const override {
-        // используем тот же метод, что и Grid
-        float3 n(0,0,0);
-        if (!isSolid(x-1,y,z)) n.x = -1;
-        else if (!isSolid(x+1,y,z)) n.x = 1;
-        if (!isSolid(x,y-1,z)) n.y = -1;
-        else if (!isSolid(x,y+1,z)) n.y = 1;
-        if (!isSolid(x,y,z-1)) n.z = -1;
-        else if (!isSolid(x,y,z+1)) n.z = 1;
-        if (LiteMath::length(n) < 0.1f) return float3(0,1,0);
-        return LiteMath::normalize(n);
-    }
-
-    int getSizeX() const override { return sizeX; }
-    int getSizeY() const override { return sizeY; }
-    int getSizeZ() const override { return sizeZ; }
-
-    size_t getMemoryUsage() const override {
-        return memory;
-    }
-
-    std::string getDescription() const override {
-        return "Octree Voxel World";
-    }
-
-    // ===== rayCast =====
-    bool rayCast(const float3& origin,
-                 const float3& dir,
-                 float maxDist,
-                 float3& hitPos,
-                 float3& normal,
-                 Voxel& hitVoxel) const override
-    {
-        float3 o = origin + float3(sizeX/2.0f, 0, sizeZ/2.0f);
-        float3 d = LiteMath::normalize(dir);
-
-        float tHit = maxDist;
-        bool hit = rayNode(root.get(), o, d, 0.0f, tHit, hitVoxel, hitPos, normal);
-        if (hit)
-            hitPos -= float3(sizeX/2.0f, 0, sizeZ/2.0f);
-        return hit;
-    }
-
-private:
-    std::unique_ptr<OctreeNode> root;
-    int sizeX{}, sizeY{}, sizeZ{};
-    mutable size_t memory = 0;
-
-    // ===== построение =====
-    std::unique_ptr<OctreeNode> buildNode(
-        const GridVoxelWorld& grid,
-        const int3& min,
-        const int3& max)
-    {
-        auto node = std::make_unique<OctreeNode>();
-        node->min = min;
-        node->max = max;
-        memory += sizeof(OctreeNode);
-
-        bool first = true;
-        Voxel ref;
-
-        for (int x=min.x; x<max.x; ++x)
-        for (int y=min.y; y<max.y; ++y)
-        for (int z=min.z; z<max.z; ++z) {
-            Voxel v = grid.getVoxel(x,y,z);
-            if (first) { ref = v; first = false; }
-            else if (v.type != ref.type) {
-                goto split;
-            }
-        }
-
-        node->isLeaf = true;
-        node->voxel = ref;
-        node->solid = (ref.type != 0);
-        return node;
-
-    split:
-        node->isLeaf = false;
-        int3 mid = (min + max) / 2;
-
-        for (int i=0;i<8;i++) {
-            int3 cmin = {
-                (i&1)?mid.x:min.x,
-                (i&2)?mid.y:min.y,
-                (i&4)?mid.z:min.z
-            };
-            int3 cmax = {
-                (i&1)?max.x:mid.x,
-                (i&2)?max.y:mid.y,
-                (i&4)?max.z:mid.z
-            };
-            if (cmin.x<cmax.x && cmin.y<cmax.y && cmin.z<cmax.z)
-                node->children[i] = buildNode(grid,cmin,cmax);
-        }
-        return node;
-    }
+// Повторное нажатие клавиши режима возвращает к полному рендеру
+void toggle_render_mode(RenderMode mode) {
+    g_renderMode = (g_renderMode == mode) ? RenderMode::FULL : mode;
+    invalidate_history();
+    printf("Режим рендера: %s\n", render_mode_name(g_renderMode));
+}
 
-    // ===== доступ =====
-    Voxel getVoxelNode(const OctreeNode* n,int x,int y,int z) const {
-        if (n->isLeaf) return n->voxel;
-        for (auto& c : n->children) {
-            if (!c) continue;
-            if (x>=c->min.x && x<c->max.x &&
-                y>=c->min.y && y<c->max.y &&
-                z>=c->min.z && z<c->max.z)
-                return getVoxelNode(c.get(),x,y,z);
-        }
-        return Voxel();
+// ============ РЕНДЕРИНГ ============
+// Освещение, текстуры, меши и полупрозрачность общие для всех режимов,
+// режимы отличаются только первичной видимостью
+void render_scene(const Camera& camera, uint32_t* out_image, int W, int H) {
+    RenderLighting lighting;
+    lighting.sun = g_shadowsEnabled ? &g_sun : nullptr;
+    lighting.ao = g_aoEnabled ? &g_ao : nullptr;
+    lighting.light = g_lightEnabled ? &g_light : nullptr;
+    if (g_irradianceEnabled) {
+        updateIrradianceCache(camera, *g_voxelWorld, g_irradiance, W, H, &lighting);
+        lighting.irradiance = &g_irradiance;
+    }
+    RenderSettings settings;
+    settings.occupancy = g_beamPrepassEnabled ? &g_occupancy : nullptr;
+    settings.meshes = &g_meshBVH;
+    settings.textures = g_texturesEnabled ? &g_blockTextures : nullptr;
+    settings.lighting = &lighting;
+    settings.translucent = g_translucentEnabled;
+
+    switch (g_renderMode) {
+    case RenderMode::REPROJECT:
+        renderVoxelWorldReprojected(camera, *g_voxelWorld, g_reprojectionCache, out_image, W, H, settings);
+        break;
+    case RenderMode::PROGRESSIVE:
+        renderVoxelWorldProgressive(camera, *g_voxelWorld, g_progressiveState, out_image, W, H, settings);
+        break;
+    case RenderMode::CHECKERBOARD:
+        renderVoxelWorldCheckerboard(camera, *g_voxelWorld, g_checkerboardState, out_image, W, H, settings);
+        break;
+    case RenderMode::RASTER:
+        renderVoxelWorldRaster(camera, *g_voxelWorld, g_surfaceChunks, g_rasterState, out_image, W, H, settings);
+        break;
+    default:
+        renderVoxelWorld(camera, *g_voxelWorld, out_image, W, H, settings);
+        break;
     }
+}
 
-    // ===== AABB =====
-    static bool rayAABB(const float3& o,const float3& d,
-                        const float3& mn,const float3& mx,
-                        float& t0,float& t1)
-    {
-        for(int i=0;i<3;i++){
-            float inv = 1.0f/d[i];
-            float tN = (mn[i]-o[i])*inv;
-            float tF = (mx[i]-o[i])*inv;
-            if (tN>tF) std::swap(tN,tF);
-            t0 = std::max(t0,tN);
-            t1 = std::min(t1,tF);
-            if (t0>t1) return false;
-        }
-        return true;
+void draw_frame_example(const Camera& camera, std::vector<uint32_t>& pixels) {
+    if (!g_voxelWorld) {
+        return;
     }
-
-    // ===== рекурсивный rayCast =====
-    bool rayNode(const OctreeNode* n,
-                 const float3& o,const float3& d,
-                 float t0,float& tHit,
-                 Voxel& voxel,
-                 float3& hitPos,
-                 float3& normal) const
-    {
-        float t1 = tHit;
-        if (!rayAABB(o,d,
-            float3(n->min),float3(n->max),t0,t1))
-            return false;
-
-        if (n->isLeaf) {
-            if (!n->solid) return false;
-
-            float t = std::max(t0, 0.0f) + 1e-4f;
-            float3 pos = o + d * t;
-
-            int x = int(floor(pos.x));
-            int y = int(floor(pos.y));
-            int z = int(floor(pos.z));
-
-            int stepX = (d.x > 0) ? 1 : -1;
-            int stepY = (d.y > 0) ? 1 : -1;
-            int stepZ = (d.z > 0) ? 1 : -1;
-
-            float nextX = (stepX > 0) ? (x + 1) : x;
-            float nextY = (stepY > 0) ? (y + 1) : y;
-            float nextZ = (stepZ > 0) ? (z + 1) : z;
-
-            float tMaxX = (d.x != 0) ? (nextX - pos.x) / d.x : FLT_MAX;
-            float tMaxY = (d.y != 0) ? (nextY - pos.y) / d.y : FLT_MAX;
-            float tMaxZ = (d.z != 0) ? (nextZ - pos.z) / d.z : FLT_MAX;
-
-            float tDeltaX = (d.x != 0) ? fabs(1.0f / d.x) : FLT_MAX;
-            float tDeltaY = (d.y != 0) ? fabs(1.0f / d.y) : FLT_MAX;
-            float tDeltaZ = (d.z != 0) ? fabs(1.0f / d.z) : FLT_MAX;
-
-            while (x>=n->min.x && x<n->max.x &&
-                y>=n->min.y && y<n->max.y &&
-                z>=n->min.z && z<n->max.z &&
-                t < tHit)
-            {
-                if (isSolid(x,y,z)) {
-                    voxel = getVoxel(x,y,z);
-                    hitPos = o + d * t;
-                    normal = getNormal(x,y,z);
-                    tHit = t;
-                    return true;
-                }
-
-                if (tMaxX < tMaxY && tMaxX < tMaxZ) {
-                    x += stepX;
-                    t = tMaxX;
-                    tMaxX += tDeltaX;
-                }
-                else if (tMaxY < tMaxZ) {
-                    y += stepY;
-                    t = tMaxY;
-                    tMaxY += tDeltaY;
-                }
-                else {
-                    z += stepZ;
-                    t = tMaxZ;
-                    tMaxZ += tDeltaZ;
-                }
-            }
-            return false;
-        }
-
-        bool hit=false;
-        for (auto& c : n->children)
-            if (c)
-                hit |= rayNode(c.get(),o,d,t0,tHit,voxel,hitPos,normal);
-        return hit;
+    if (!g_dynamicResolutionEnabled) {
+        render_scene(camera, pixels.data(), SCREEN_WIDTH, SCREEN_HEIGHT);
+        return;
     }
-};
-
-// ============ ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ ============
-std::unique_ptr<IVoxelWorld> g_voxelWorld;
-
-// ============ РАЗРЕШЕНИЕ ЭКРАНА ============
-static constexpr int SCREEN_WIDTH  = 640;
-static constexpr int SCREEN_HEIGHT = 480;
-
-// ============ ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ============
-float rad_to_deg(float rad) { return rad * 180.0f / LiteMath::M_PI; }
-
-uint32_t float3_to_RGBA8(float3 c) {
-    uint8_t r = (uint8_t)(std::clamp(c.x, 0.0f, 1.0f) * 255.0f);
-    uint8_t g = (uint8_t)(std::clamp(c.y, 0.0f, 1.0f) * 255.0f);
-    uint8_t b = (uint8_t)(std::clamp(c.z, 0.0f, 1.0f) * 255.0f);
-    return 0xFF000000 | (r << 16) | (g << 8) | b;
+    
+    // Рендерим в уменьшенный буфер и растягиваем до размера SDL-текстуры
+    auto start = std::chrono::high_resolution_clock::now();
+    int2 res = g_dynamicResolution.resolution(SCREEN_WIDTH, SCREEN_HEIGHT);
+    g_renderPixels.resize(res.x * res.y);
+    render_scene(camera, g_renderPixels.data(), res.x, res.y);
+    upscaleBilinear(g_renderPixels.data(), res.x, res.y, pixels.data(), SCREEN_WIDTH, SCREEN_HEIGHT);
+    auto end = std::chrono::high_resolution_clock::now();
+    g_dynamicResolution.update(std::chrono::duration<float, std::milli>(end - start).count());
 }
 
-// ============ РЕНДЕРИНГ ============
-void renderVoxelWorld(const Camera& camera, const IVoxelWorld& world, 
-                     uint32_t* out_image, int W, int H) {
-    
-    LiteMath::float4x4 view = LiteMath::lookAt(camera.pos, camera.target, camera.up);
-    LiteMath::float4x4 proj = LiteMath::perspectiveMatrix(
-        rad_to_deg(camera.fov_rad), (float)W/(float)H, camera.z_near, camera.z_far);
-    LiteMath::float4x4 viewProjInv = LiteMath::inverse4x4(proj * view);
+// Загружает OBJ как меш сцены (без вокселизации): наибольшая сторона модели -
+// size единиц мира, модель центрируется по x/z над точкой base.
+bool load_scene_mesh(const char* fileName, float size, const float3& base) {
+    cmesh4::SimpleMesh mesh = cmesh4::LoadMeshFromObjCached(fileName);
+    if (mesh.TrianglesNum() == 0) return false;
     
-    const float3 light_dir = LiteMath::normalize(float3(-1.0f, -1.0f, -1.0f));
-    
-    // Убираем антиалиасинг для скорости
-    for (int y = 0; y < H; y++) {
-        for (int x = 0; x < W; x++) {
-            // Получаем луч через пиксель
-            float u = (x + 0.5f) / W;
-            float v = (y + 0.5f) / H;
-            float ndc_x = 2.0f * u - 1.0f;
-            float ndc_y = 1.0f - 2.0f * v; // Инвертируем ось Y
-            
-            float4 point_NDC = float4(ndc_x, ndc_y, 0.0f, 1.0f);
-            float4 point_W = viewProjInv * point_NDC;
-            float3 point = LiteMath::to_float3(point_W) / point_W.w;
-            float3 ray_pos = camera.pos;
-            float3 ray_dir = LiteMath::normalize(point - ray_pos);
-            
-            // Трассируем луч через мир
-            float3 hitPos, normal;
-            Voxel hitVoxel;
-            float3 color(0.0f, 0.0f, 0.0f);
-            
-            if (world.rayCast(ray_pos, ray_dir, 1000.0f, hitPos, normal, hitVoxel)) {
-                // Базовое освещение Ламберта
-                float lambert = std::max(0.0f, LiteMath::dot(normal, -light_dir));
-                
-                // Получаем цвет из вокселя
-                float3 base_color = VoxelMaterials::getColorAsFloat3(hitVoxel.color);
-                color = base_color * (0.25f + 0.75f * lambert);
-            }
-            
-            out_image[y * W + x] = float3_to_RGBA8(color);
-        }
+    float3 boundsMin, boundsMax;
+    const float scale = 1.0f / voxelSizeForResolution(mesh, (int)size, boundsMin, boundsMax);
+    const float3 extent = (boundsMax - boundsMin) * scale;
+    const float3 corner = base - float3(0.5f * extent.x, 0.0f, 0.5f * extent.z);
+    for (auto& p : mesh.vPos4f) {
+        const float3 q = (LiteMath::to_float3(p) - boundsMin) * scale + corner;
+        p = float4(q.x, q.y, q.z, 1.0f);
     }
-}
-
-void draw_frame_example(const Camera& camera, std::vector<uint32_t>& pixels) {
-    if (g_voxelWorld) {
-        renderVoxelWorld(camera, *g_voxelWorld, pixels.data(), SCREEN_WIDTH, SCREEN_HEIGHT);
+    
+    std::vector<Voxel> materials;
+    for (uint32_t m : mesh.matIndices) {
+        while (materials.size() <= m) materials.push_back(voxelForMaterial((uint32_t)materials.size(), {}));
     }
+    g_meshBVH.build(mesh, materials);
+    return true;
 }
 
 // ============ УПРАВЛЕНИЕ КАМЕРОЙ ============
@@ -847,6 +334,56 @@ void InitializeFreeCameraFromCamera(const Camera& camera) {
 int main(int argc, char** args) {
     printf("=== Воксельный рендерер с интерфейсом ===\n");
     
+    // Аргументы: --dynamic-res [бюджет кадра в мс], --reproject, --progressive [шаг решетки, степень двойки], --checkerboard, --raster,
+    // --export-obj <файл>, --import-obj <файл> [размер модели в вокселях], --mesh <файл> [размер модели], --ao-rays
+    const char* exportObjPath = nullptr;
+    const char* importObjPath = nullptr;
+    const char* meshPath = nullptr;
+    int importResolution = 48;
+    float meshSize = 48.0f;
+    bool aoRays = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(args[i], "--ao-rays") == 0) {
+            aoRays = true;
+        }
+        if (strcmp(args[i], "--mesh") == 0 && i + 1 < argc) {
+            meshPath = args[++i];
+            if (i + 1 < argc && atof(args[i + 1]) > 0.0f) {
+                meshSize = (float)atof(args[++i]);
+            }
+        }
+        if (strcmp(args[i], "--import-obj") == 0 && i + 1 < argc) {
+            importObjPath = args[++i];
+            if (i + 1 < argc && atoi(args[i + 1]) > 0) {
+                importResolution = atoi(args[++i]);
+            }
+        }
+        if (strcmp(args[i], "--export-obj") == 0 && i + 1 < argc) {
+            exportObjPath = args[++i];
+        }
+        if (strcmp(args[i], "--raster") == 0) {
+            g_renderMode = RenderMode::RASTER;
+        }
+        if (strcmp(args[i], "--checkerboard") == 0) {
+            g_renderMode = RenderMode::CHECKERBOARD;
+        }
+        if (strcmp(args[i], "--reproject") == 0) {
+            g_renderMode = RenderMode::REPROJECT;
+        }
+        if (strcmp(args[i], "--progressive") == 0) {
+            g_renderMode = RenderMode::PROGRESSIVE;
+            if (i + 1 < argc && atoi(args[i + 1]) > 0) {
+                g_progressiveState.movingStep = progressiveStep(atoi(args[++i]));
+            }
+        }
+        if (strcmp(args[i], "--dynamic-res") == 0) {
+            g_dynamicResolutionEnabled = true;
+            if (i + 1 < argc && atof(args[i + 1]) > 0.0f) {
+                g_dynamicResolution.targetMs = (float)atof(args[++i]);
+            }
+        }
+    }
+    
     // 1. Создаем воксельный мир (пока регулярная сетка)
     const int WORLD_SIZE_X = 128;
     const int WORLD_SIZE_Y = 64;
@@ -859,10 +396,66 @@ int main(int argc, char** args) {
     printf("Генерация холмистого ландшафта...\n");
     TerrainGenerator::createHillyTerrain(*gridWorld);
     
+    // Таблица материалов нужна до всего, что строится по миру: свет берет из нее
+    // прозрачность и излучение, модели - материалы
+    if (materialTable().load("materials.txt"))
+        printf("Материалы: %d из materials.txt\n", materialTable().count());
+    if (importObjPath) {
+        // Модель ставится в центр мира, основанием на уровень 16
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t filled = voxelizeObjIntoWorld(importObjPath, *gridWorld, importResolution,
+                                             int3(WORLD_SIZE_X / 2, 16, WORLD_SIZE_Z / 2));
+        auto end = std::chrono::high_resolution_clock::now();
+        printf("Модель %s: %zu вокселей за %.1f мс\n", importObjPath, filled,
+               std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    
     // 3. Сохраняем указатель на интерфейс
     g_voxelWorld = std::make_unique<OctreeVoxelWorld>(*gridWorld);
+    g_occupancy.build(*gridWorld);
+    g_surfaceChunks = extractVoxelSurface(*gridWorld);
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        g_ao.build(*gridWorld, aoRays);
+        auto end = std::chrono::high_resolution_clock::now();
+        printf("AO%s: %.1f KB за %.1f мс\n", aoRays ? " (с лучами)" : "", g_ao.getMemoryUsage() / 1024.0,
+               std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        g_light.build(*gridWorld);
+        auto end = std::chrono::high_resolution_clock::now();
+        printf("Свет: %.1f KB за %.1f мс\n", g_light.getMemoryUsage() / 1024.0,
+               std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    
+    if (meshPath) {
+        // Меш стоит в центре мира на уровне 16, как и вокселизированная модель
+        auto start = std::chrono::high_resolution_clock::now();
+        if (load_scene_mesh(meshPath, meshSize, float3(0.0f, 16.0f, 0.0f))) {
+            auto end = std::chrono::high_resolution_clock::now();
+            printf("Меш %s: %zu треугольников, BVH %zu узлов за %.1f мс\n", meshPath,
+                   g_meshBVH.triangleCount(), g_meshBVH.nodeCount(),
+                   std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        g_textureAtlas.loadDirectoryCached("textures", "textures.atlas");
+        g_blockTextures = BlockTextures::bind(g_textureAtlas);
+        auto end = std::chrono::high_resolution_clock::now();
+        printf("Текстуры: %d (%dx%d, %d мипов) за %.1f мс%s\n", g_textureAtlas.textureCount(),
+               g_textureAtlas.tileSize(), g_textureAtlas.tileSize(), g_textureAtlas.levels(),
+               std::chrono::duration<double, std::milli>(end - start).count(),
+               g_textureAtlas.fromCache() ? " (из кэша)" : "");
+    }
     
     printf("Ландшафт сгенерирован.\n");
+    if (exportObjPath) {
+        exportVoxelWorldObj(*g_voxelWorld, exportObjPath);
+        printf("Мир сохранен в %s\n", exportObjPath);
+    }
     printf("Описание: %s\n", g_voxelWorld->getDescription().c_str());
     printf("Используемая память: %.2f MB\n\n", 
            g_voxelWorld->getMemoryUsage() / (1024.0f * 1024.0f));
@@ -939,6 +532,19 @@ int main(int argc, char** args) {
     printf("  - Колесико: Зум\n");
     printf("  - WASD: Движение камеры\n");
     printf("  - Q/E: Движение вверх/вниз\n");
+    printf("  - T: Репроецирование попаданий прошлого кадра\n");
+    printf("  - P: Прогрессивное уточнение (1 луч на %d пикселей в движении)\n",
+           g_progressiveState.movingStep * g_progressiveState.movingStep);
+    printf("  - B: Beam-проход (старт лучей с безопасной глубины тайла)\n");
+    printf("  - C: Шахматный рендер (половина лучей за кадр)\n");
+    printf("  - V: Растеризация граней вместо первичных лучей\n");
+    printf("  - R: Динамическое разрешение (бюджет %.1f мс)\n", g_dynamicResolution.targetMs);
+    printf("  - X: Текстуры блоков\n");
+    printf("  - H: Тени от солнца\n");
+    printf("  - O: Запеченное затенение граней (AO)\n");
+    printf("  - L: Свет неба и излучающих блоков по вокселям\n");
+    printf("  - G: Кэш освещенности (рассеянный свет)\n");
+    printf("  - N: Полупрозрачная вода\n");
     printf("  - ESC: Выход\n\n");
 
     // Основной цикл
@@ -954,6 +560,56 @@ int main(int argc, char** args) {
                 if (ev.key.keysym.sym == SDLK_ESCAPE) {
                     running = false;
                 }
+                if (ev.key.keysym.sym == SDLK_t) {
+                    toggle_render_mode(RenderMode::REPROJECT);
+                }
+                if (ev.key.keysym.sym == SDLK_p) {
+                    toggle_render_mode(RenderMode::PROGRESSIVE);
+                }
+                if (ev.key.keysym.sym == SDLK_b) {
+                    g_beamPrepassEnabled = !g_beamPrepassEnabled;
+                    printf("Beam-проход: %s\n", g_beamPrepassEnabled ? "вкл" : "выкл");
+                }
+                if (ev.key.keysym.sym == SDLK_c) {
+                    toggle_render_mode(RenderMode::CHECKERBOARD);
+                }
+                if (ev.key.keysym.sym == SDLK_v) {
+                    toggle_render_mode(RenderMode::RASTER);
+                }
+                if (ev.key.keysym.sym == SDLK_x) {
+                    g_texturesEnabled = !g_texturesEnabled;
+                    invalidate_history();
+                    printf("Текстуры: %s\n", g_texturesEnabled ? "вкл" : "выкл");
+                }
+                if (ev.key.keysym.sym == SDLK_h) {
+                    g_shadowsEnabled = !g_shadowsEnabled;
+                    invalidate_history();
+                    printf("Тени от солнца: %s\n", g_shadowsEnabled ? "вкл" : "выкл");
+                }
+                if (ev.key.keysym.sym == SDLK_o) {
+                    g_aoEnabled = !g_aoEnabled;
+                    invalidate_history();
+                    printf("AO: %s\n", g_aoEnabled ? "вкл" : "выкл");
+                }
+                if (ev.key.keysym.sym == SDLK_l) {
+                    g_lightEnabled = !g_lightEnabled;
+                    invalidate_history();
+                    printf("Свет по вокселям: %s\n", g_lightEnabled ? "вкл" : "выкл");
+                }
+                if (ev.key.keysym.sym == SDLK_g) {
+                    g_irradianceEnabled = !g_irradianceEnabled;
+                    invalidate_history();
+                    printf("Кэш освещенности: %s\n", g_irradianceEnabled ? "вкл" : "выкл");
+                }
+                if (ev.key.keysym.sym == SDLK_n) {
+                    g_translucentEnabled = !g_translucentEnabled;
+                    invalidate_history();
+                    printf("Полупрозрачная вода: %s\n", g_translucentEnabled ? "вкл" : "выкл");
+                }
+                if (ev.key.keysym.sym == SDLK_r) {
+                    g_dynamicResolutionEnabled = !g_dynamicResolutionEnabled;
+                    printf("Динамическое разрешение: %s\n", g_dynamicResolutionEnabled ? "вкл" : "выкл");
+                }
                 // Обновление модификаторов
                 if (ev.key.keysym.sym == SDLK_LALT || ev.key.keysym.sym == SDLK_RALT) {
                     alt_pressed = true;
@@ -1038,6 +694,21 @@ int main(int argc, char** args) {
 
         if (frameNum % 60 == 0) {
             printf("FPS: %.1f\n", 1.0f / dt);
+            if (g_renderMode == RenderMode::REPROJECT) {
+                printf("Полных лучей за кадр: %d\n", g_reprojectionCache.tracedRays);
+            }
+            if (g_renderMode == RenderMode::PROGRESSIVE) {
+                printf("Лучей за кадр: %d (шаг решетки %d)\n",
+                       g_progressiveState.tracedRays, g_progressiveState.step);
+            }
+            if (g_renderMode == RenderMode::RASTER) {
+                printf("Видимых чанков: %d, треугольников: %d\n",
+                       g_rasterState.visibleChunks, g_rasterState.rasterTriangles);
+            }
+            if (g_dynamicResolutionEnabled) {
+                int2 res = g_dynamicResolution.resolution(SCREEN_WIDTH, SCREEN_HEIGHT);
+                printf("Разрешение рендера: %dx%d (%.1f мс)\n", res.x, res.y, g_dynamicResolution.avgMs);
+            }
         }
 
         // Движение камеры
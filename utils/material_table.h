@@ -0,0 +1,145 @@
+#pragma once
+
+#include "utils/texture_atlas.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+
+// ============ ТАБЛИЦА МАТЕРИАЛОВ ============
+// Все, что зависит только от типа вокселя: альбедо, текстуры граней, флаги.
+// Воксель хранит лишь номер материала, а шейдинг делает одно чтение из
+// таблицы по этому номеру (MAX_MATERIALS * 12 байт - целиком в L1).
+//
+// Описание - текстовый файл, по материалу на строку, '#' - комментарий:
+//   <id> <имя> <RRGGBB> <верх> <бок> <низ> [emissive=N] [transparent]
+// Текстуры граней - имена в TextureAtlas (имя файла без расширения),
+// "-" - грань без текстуры (только альбедо). N - уровень излучения 1..15.
+
+enum MaterialFlags : uint8_t {
+    MATERIAL_EMISSIVE    = 1,
+    MATERIAL_TRANSPARENT = 2,
+};
+
+struct MaterialInfo {
+    enum Face { TOP = 0, SIDE = 1, BOTTOM = 2 };
+
+    uint32_t albedo   = 0xFFFFFFFF;     // ARGB8
+    int16_t  faces[3] = {-1, -1, -1};   // индексы текстур в атласе, -1 - альбедо
+    uint8_t  flags    = 0;              // MaterialFlags
+    uint8_t  emission = 0;              // уровень излучения 0..15
+
+    bool emissive() const    { return flags & MATERIAL_EMISSIVE; }
+    bool transparent() const { return flags & MATERIAL_TRANSPARENT; }
+};
+
+// Встроенное описание: совпадает с materials.txt в корне репозитория
+static constexpr const char* DEFAULT_MATERIALS =
+    "0 air   000000 - - - transparent\n"
+    "1 grass 228B22 grass_carried grass_side_carried dirt\n"
+    "2 dirt  8B4513 dirt dirt dirt\n"
+    "3 stone 808080 stone stone stone\n"
+    "4 water 1E90FF water water water transparent\n"
+    "5 glowstone FFD27F glowstone glowstone glowstone emissive=15\n";
+
+class MaterialTable {
+public:
+    // Номер материала - uint8_t в Voxel, поэтому индекс в таблицу всегда валиден
+    static constexpr int MAX_MATERIALS = 256;
+
+    MaterialTable() {
+        std::istringstream in(DEFAULT_MATERIALS);
+        parse(in, "встроенные материалы");
+    }
+
+    const MaterialInfo& operator[](uint8_t id) const { return entries_[id]; }
+
+    // Загружает описание поверх текущих материалов. false - файла нет.
+    // Строки с ошибками пропускаются с предупреждением.
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        parse(in, path);
+        texturesBound_ = false;
+        return true;
+    }
+
+    // Переводит имена текстур граней в индексы атласа. Без текстуры в
+    // атласе грань рисуется альбедо.
+    void bindTextures(const TextureAtlas& atlas) {
+        for (int id = 0; id < MAX_MATERIALS; id++)
+            for (int face = 0; face < 3; face++)
+                entries_[id].faces[face] = faceNames_[id][face].empty() ? -1 : (int16_t)atlas.find(faceNames_[id][face]);
+        texturesBound_ = true;
+    }
+
+    bool texturesBound() const { return texturesBound_; }
+
+    // Номер материала по имени, -1 - нет такого
+    int find(const std::string& name) const {
+        for (int id = 0; id < MAX_MATERIALS; id++)
+            if (names_[id] == name) return id;
+        return -1;
+    }
+
+    const std::string& name(uint8_t id) const { return names_[id]; }
+
+    int count() const {
+        return (int)std::count_if(names_, names_ + MAX_MATERIALS, [](const std::string& n) { return !n.empty(); });
+    }
+
+    // Горячая часть таблицы, которую читает шейдинг
+    size_t getMemoryUsage() const { return sizeof(entries_); }
+
+private:
+    MaterialInfo entries_[MAX_MATERIALS];
+    std::string  names_[MAX_MATERIALS];          // холодные данные: имена материалов
+    std::string  faceNames_[MAX_MATERIALS][3];   // и текстур их граней
+    bool texturesBound_ = false;
+
+    void parse(std::istream& in, const std::string& source) {
+        std::string line;
+        for (int lineNo = 1; std::getline(in, line); lineNo++) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream fields(line);
+            int id;
+            std::string name, color, faces[3];
+            if (!(fields >> id)) continue; // пустая строка или комментарий
+            if (!(fields >> name >> color >> faces[0] >> faces[1] >> faces[2]) ||
+                id < 0 || id >= MAX_MATERIALS || color.size() != 6 ||
+                color.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+                fprintf(stderr, "%s:%d: неверное описание материала\n", source.c_str(), lineNo);
+                continue;
+            }
+
+            MaterialInfo info;
+            info.albedo = 0xFF000000u | (uint32_t)strtoul(color.c_str(), nullptr, 16);
+            std::string option;
+            while (fields >> option) {
+                if (option == "transparent") {
+                    info.flags |= MATERIAL_TRANSPARENT;
+                } else if (option.rfind("emissive=", 0) == 0) {
+                    info.flags |= MATERIAL_EMISSIVE;
+                    info.emission = (uint8_t)std::clamp(atoi(option.c_str() + 9), 1, 15);
+                } else {
+                    fprintf(stderr, "%s:%d: неизвестный флаг материала '%s'\n", source.c_str(), lineNo, option.c_str());
+                }
+            }
+
+            entries_[id] = info;
+            names_[id] = name;
+            for (int face = 0; face < 3; face++)
+                faceNames_[id][face] = faces[face] == "-" ? std::string() : faces[face];
+        }
+    }
+};
+
+// Таблица, по которой шейдятся все воксели и меши
+inline MaterialTable& materialTable() {
+    static MaterialTable table;
+    return table;
+}
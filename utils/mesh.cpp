@@ -2,7 +2,17 @@
 #include <cstring>
 #include <fstream>
 #include <cstdio>
-#include <unordered_map>
+#include <string>
+#include <algorithm>
+#include <omp.h>
+#include <sys/stat.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
@@ -11,6 +21,28 @@
 
 namespace cmesh4 {
 
+static std::string obj_base_dir(const char* a_fileName)
+{
+  std::string path(a_fileName);
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+// Material ids are stored as "usemtl material_<id>" groups with a companion .mtl file that
+// defines material_0..material_<max> in order, so tinyobj assigns the same ids on load.
+// Meshes without non-zero material ids are written without materials.
+static void SaveMaterialsToMtl(const std::string &a_fileName, unsigned a_maxMatId)
+{
+  std::ofstream out(a_fileName);
+  if (!out)
+  {
+    printf("[SaveMeshToObj::ERROR] Failed to create material file: %s\n", a_fileName.c_str());
+    return;
+  }
+  for (unsigned i = 0; i <= a_maxMatId; ++i)
+    out << "newmtl material_" << i << "\nKd 0.8 0.8 0.8\n\n";
+}
+
 void SaveMeshToObj(const char* a_fileName, const SimpleMesh &mesh)
 {
   std::ofstream out(a_fileName);
@@ -32,6 +64,21 @@ void SaveMeshToObj(const char* a_fileName, const SimpleMesh &mesh)
   assert(mesh.vNorm4f.size() == sz);
   assert(mesh.vTexCoord2f.size() == sz);
 
+  unsigned maxMatId = 0;
+  for (unsigned mid : mesh.matIndices)
+    maxMatId = std::max(maxMatId, mid);
+  const bool withMaterials = maxMatId > 0 && mesh.matIndices.size() == mesh.indices.size() / 3;
+  if (withMaterials)
+  {
+    std::string mtlName(a_fileName);
+    size_t dot = mtlName.find_last_of('.');
+    if (dot != std::string::npos && dot > obj_base_dir(a_fileName).size())
+      mtlName = mtlName.substr(0, dot);
+    mtlName += ".mtl";
+    SaveMaterialsToMtl(mtlName, maxMatId);
+    header += "mtllib " + mtlName.substr(obj_base_dir(a_fileName).size()) + "\n";
+  }
+
   for (int i = 0; i < sz; ++i)
   {
     v_data += "v " + std::to_string(mesh.vPos4f[i].x) + " " + std::to_string(mesh.vPos4f[i].y) + " " + std::to_string(mesh.vPos4f[i].z) + "\n";
@@ -40,6 +87,8 @@ void SaveMeshToObj(const char* a_fileName, const SimpleMesh &mesh)
   }
   for (int i = 0; i < mesh.indices.size() / 3; ++i)
   {
+    if (withMaterials && (i == 0 || mesh.matIndices[i] != mesh.matIndices[i-1]))
+      f_data += "usemtl material_" + std::to_string(mesh.matIndices[i]) + "\n";
     f_data += "f " + std::to_string(mesh.indices[3*i]+1) + "/" + std::to_string(mesh.indices[3*i]+1) + "/" + std::to_string(mesh.indices[3*i]+1) + " " +
       std::to_string(mesh.indices[3*i+1]+1) + "/" + std::to_string(mesh.indices[3*i+1]+1) + "/" + std::to_string(mesh.indices[3*i+1]+1) + " " +
       std::to_string(mesh.indices[3*i+2]+1) + "/" + std::to_string(mesh.indices[3*i+2]+1) + "/" + std::to_string(mesh.indices[3*i+2]+1) + "\n";
@@ -151,30 +200,68 @@ void fix_missing(cmesh4::SimpleMesh &mesh, int default_mat_id)
   mesh.matIndices.resize(mesh.indices.size() / 3, default_mat_id);
 }
 
-struct TinyObjIndexEqual
+// Open-addressing (linear probing) table from an OBJ corner (v/vt/vn) to the mesh vertex index.
+// One flat allocation sized up front, no per-node allocations as in std::unordered_map.
+class VertexDedupTable
 {
-  bool operator()(const tinyobj::index_t &lhs, const tinyobj::index_t &rhs) const
+public:
+  explicit VertexDedupTable(size_t a_expectedKeys)
   {
-    return lhs.vertex_index == rhs.vertex_index &&
-          lhs.normal_index == rhs.normal_index &&
-          lhs.texcoord_index == rhs.texcoord_index;
+    size_t capacity = 16;
+    while (capacity < 2 * a_expectedKeys)
+      capacity *= 2;
+    m_mask = capacity - 1;
+    m_slots.resize(capacity);
   }
-};
 
-struct TinyObjIndexHasher
-{
-  size_t operator()(const tinyobj::index_t &index) const
+  // Returns the value stored for a_key; if the key is new, stores a_newValue and sets a_inserted
+  uint32_t FindOrInsert(const tinyobj::index_t &a_key, uint32_t a_newValue, bool &a_inserted)
   {
-    return ((std::hash<int>()(index.vertex_index) ^
-            (std::hash<int>()(index.normal_index) << 1)) >> 1) ^
-            (std::hash<int>()(index.texcoord_index) << 1);
+    size_t i = Hash(a_key) & m_mask;
+    for (;;)
+    {
+      Slot &slot = m_slots[i];
+      if (slot.value == EMPTY)
+      {
+        slot.key = a_key;
+        slot.value = a_newValue;
+        a_inserted = true;
+        return a_newValue;
+      }
+      if (slot.key.vertex_index == a_key.vertex_index && slot.key.normal_index == a_key.normal_index &&
+          slot.key.texcoord_index == a_key.texcoord_index)
+      {
+        a_inserted = false;
+        return slot.value;
+      }
+      i = (i + 1) & m_mask;
+    }
+  }
+
+private:
+  static const uint32_t EMPTY = 0xFFFFFFFFu;
+
+  struct Slot
+  {
+    tinyobj::index_t key;
+    uint32_t value = EMPTY;
+  };
+
+  static size_t Hash(const tinyobj::index_t &a_key)
+  {
+    uint64_t h = uint64_t(uint32_t(a_key.vertex_index)) * 0x9E3779B97F4A7C15ULL;
+    h ^= uint64_t(uint32_t(a_key.normal_index)) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= uint64_t(uint32_t(a_key.texcoord_index)) * 0x165667B19E3779F9ULL;
+    return size_t(h ^ (h >> 29));
   }
+
+  std::vector<Slot> m_slots;
+  size_t m_mask = 0;
 };
 
-SimpleMesh LoadMeshFromObj(const char* a_fileName, bool verbose)
+// Reference path: tinyobj parses the whole file, handles every OBJ feature it supports
+static SimpleMesh LoadMeshFromObjTinyObj(const char* a_fileName, bool verbose)
 {
-  if (verbose)
-    printf("[LoadMesh::INFO] Loading OBJ file %s\n", a_fileName);
   SimpleMesh mesh;
 
   tinyobj::attrib_t attrib;
@@ -184,7 +271,9 @@ SimpleMesh LoadMeshFromObj(const char* a_fileName, bool verbose)
   std::string warn;
   std::string err;
 
-  bool loading_result = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, a_fileName);
+  const std::string baseDir = obj_base_dir(a_fileName);
+  bool loading_result = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, a_fileName,
+                                         baseDir.empty() ? nullptr : baseDir.c_str());
 
   if (!loading_result)
   {
@@ -204,12 +293,12 @@ SimpleMesh LoadMeshFromObj(const char* a_fileName, bool verbose)
   const LiteMath::float4 default_tangent = float4(1, 0, 0, 0);
   const LiteMath::float2 default_texcoord = float2(0, 0);
 
-  std::unordered_map<tinyobj::index_t, uint32_t, TinyObjIndexHasher, TinyObjIndexEqual> uniqueVertIndices = {};
-
   uint32_t numIndices = 0;
   for (const auto& shape : shapes)
   numIndices += shape.mesh.indices.size();
 
+  VertexDedupTable uniqueVertIndices(numIndices);
+
   mesh.vPos4f.reserve(attrib.vertices.size() / 3);
   mesh.vNorm4f.reserve(attrib.vertices.size() / 3);
   mesh.vTang4f.reserve(attrib.vertices.size() / 3);
@@ -222,17 +311,10 @@ SimpleMesh LoadMeshFromObj(const char* a_fileName, bool verbose)
 
     for (const auto& index : shape.mesh.indices)
     {
-      uint32_t my_index = 0;
-      auto it = uniqueVertIndices.find(index);
-      if (it != uniqueVertIndices.end())
-      {
-        my_index = it->second;
-      }
-      else
+      bool inserted = false;
+      uint32_t my_index = uniqueVertIndices.FindOrInsert(index, static_cast<uint32_t>(mesh.vPos4f.size()), inserted);
+      if (inserted)
       {
-        uniqueVertIndices.insert({index, static_cast<uint32_t>(mesh.vPos4f.size())});
-        my_index = static_cast<uint32_t>(mesh.vPos4f.size());
-
         assert(index.vertex_index >= 0 && index.vertex_index < attrib.vertices.size() / 3);
         mesh.vPos4f.push_back({attrib.vertices[3 * index.vertex_index + 0],
           attrib.vertices[3 * index.vertex_index + 1],
@@ -282,4 +364,888 @@ SimpleMesh LoadMeshFromObj(const char* a_fileName, bool verbose)
   assert(check_is_valid(mesh, true));
   return mesh;
 }
+
+// Parallel OBJ loading. The file is read into memory and split into line-aligned chunks that are
+// processed in three parallel passes:
+//   1) count v/vn/vt lines and collect mtllib/usemtl statements of each chunk;
+//   2) parse attributes straight into the global arrays (chunk offsets are known after pass 1)
+//      and faces with absolute indices, so relative (negative) indices resolve as in tinyobj;
+//   3) triangulate faces into the global corner array, quads split like tinyobj does.
+// Numbers and face corners go through tinyobj's own helpers, so the mesh is identical to
+// LoadMeshFromObjTinyObj. A file using anything this path does not reproduce (polygons with
+// more than 4 vertices, invalid indices, mtllib after usemtl) returns false and goes to tinyobj.
+struct ObjChunk
+{
+  const char* begin = nullptr;
+  const char* end   = nullptr;
+
+  size_t numV = 0, numVn = 0, numVt = 0;
+  size_t baseV = 0, baseVn = 0, baseVt = 0;
+  std::vector<std::string> mtllibLines;
+  bool hasUsemtl = false;
+  bool mtllibAfterUsemtl = false;
+  std::string lastUsemtl;
+  int startMaterial = -1;
+
+  std::vector<tinyobj::index_t> faceCorners;  // 3 or 4 corners per face
+  std::vector<unsigned char>    faceSizes;
+  std::vector<int>              faceMaterials;
+  size_t numTriangles = 0;
+  size_t baseTriangle = 0;
+  bool   failed = false;
+};
+
+// Calls a_func(lineBegin, lineEnd) for each line; line endings as in tinyobj's safeGetline
+template<typename F>
+static void for_each_obj_line(const char* a_begin, const char* a_end, F a_func)
+{
+  const char* p = a_begin;
+  while (p < a_end)
+  {
+    const char* e = p;
+    while (e < a_end && *e != '\n' && *e != '\r')
+      ++e;
+    const char* lineEnd = e;
+    if (e + 1 < a_end && e[0] == '\r' && e[1] == '\n')
+      ++e;
+    if (!a_func(p, lineEnd))
+      return;
+    p = e + 1;
+  }
+}
+
+static bool LoadMeshFromObjParallel(const char* a_fileName, SimpleMesh &mesh, bool verbose)
+{
+  std::ifstream in(a_fileName, std::ios::binary | std::ios::ate);
+  if (!in)
+    return false;
+  const size_t fileSize = (size_t)in.tellg();
+  std::vector<char> text(fileSize + 1, '\0');  // trailing '\0' keeps tinyobj's helpers inside the buffer
+  in.seekg(0);
+  in.read(text.data(), fileSize);
+  if (!in)
+    return false;
+
+  // Line-aligned chunks of at least 256 KB, a few per thread for load balance
+  const size_t maxChunks = size_t(omp_get_max_threads()) * 4;
+  const size_t numChunks = std::max<size_t>(1, std::min(maxChunks, fileSize / (256 * 1024)));
+  std::vector<ObjChunk> chunks(numChunks);
+  const char* textEnd = text.data() + fileSize;
+  const char* chunkBegin = text.data();
+  for (size_t c = 0; c < numChunks; ++c)
+  {
+    const char* chunkEnd = textEnd;
+    if (c + 1 < numChunks)
+    {
+      chunkEnd = std::max<const char*>(chunkBegin, text.data() + fileSize * (c + 1) / numChunks);
+      while (chunkEnd < textEnd && *chunkEnd != '\n' && *chunkEnd != '\r')
+        ++chunkEnd;
+      if (chunkEnd + 1 < textEnd && chunkEnd[0] == '\r' && chunkEnd[1] == '\n')
+        ++chunkEnd;
+      chunkEnd = std::min(textEnd, chunkEnd + 1);
+    }
+    chunks[c].begin = chunkBegin;
+    chunks[c].end   = chunkEnd;
+    chunkBegin = chunkEnd;
+  }
+
+  // Pass 1: attribute counts and material statements
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int c = 0; c < (int)numChunks; ++c)
+  {
+    ObjChunk &chunk = chunks[c];
+    for_each_obj_line(chunk.begin, chunk.end, [&](const char* a_line, const char* a_lineEnd) {
+      const char* token = a_line + strspn(a_line, " \t");
+      if (token >= a_lineEnd)
+        return true;
+      if (token[0] == 'v' && IS_SPACE(token[1]))
+        chunk.numV++;
+      else if (token[0] == 'v' && token[1] == 'n' && IS_SPACE(token[2]))
+        chunk.numVn++;
+      else if (token[0] == 'v' && token[1] == 't' && IS_SPACE(token[2]))
+        chunk.numVt++;
+      else if (strncmp(token, "usemtl", 6) == 0)
+      {
+        const std::string line(token + 6, a_lineEnd);
+        const char* name = line.c_str();
+        chunk.lastUsemtl = tinyobj::parseString(&name);
+        chunk.hasUsemtl = true;
+      }
+      else if (strncmp(token, "mtllib", 6) == 0 && IS_SPACE(token[6]))
+      {
+        chunk.mtllibAfterUsemtl |= chunk.hasUsemtl;
+        chunk.mtllibLines.push_back(std::string(token + 7, a_lineEnd));
+      }
+      return true;
+    });
+  }
+
+  // Chunk offsets, materials (loaded in file order, as tinyobj does) and the material
+  // that is active at the start of every chunk
+  std::string baseDir = obj_base_dir(a_fileName);
+  tinyobj::MaterialFileReader readMaterial(baseDir);
+  std::vector<tinyobj::material_t> materials;
+  std::map<std::string, int> materialMap;
+  std::set<std::string> materialFiles;
+  size_t numV = 0, numVn = 0, numVt = 0;
+  bool seenUsemtl = false;
+  for (ObjChunk &chunk : chunks)
+  {
+    chunk.baseV  = numV;  numV  += chunk.numV;
+    chunk.baseVn = numVn; numVn += chunk.numVn;
+    chunk.baseVt = numVt; numVt += chunk.numVt;
+    if (!chunk.mtllibLines.empty() && (seenUsemtl || chunk.mtllibAfterUsemtl))
+      return false;
+    seenUsemtl |= chunk.hasUsemtl;
+
+    for (const std::string &line : chunk.mtllibLines)
+    {
+      std::vector<std::string> fileNames;
+      tinyobj::SplitString(line, ' ', '\\', fileNames);
+      for (const std::string &fileName : fileNames)
+      {
+        if (materialFiles.count(fileName) > 0)
+          break;
+        std::string warn, err;
+        if (readMaterial(fileName.c_str(), &materials, &materialMap, &warn, &err))
+        {
+          materialFiles.insert(fileName);
+          break;
+        }
+      }
+    }
+  }
+  int material = -1;
+  for (ObjChunk &chunk : chunks)
+  {
+    chunk.startMaterial = material;
+    if (chunk.hasUsemtl)
+    {
+      auto it = materialMap.find(chunk.lastUsemtl);
+      material = (it != materialMap.end()) ? it->second : -1;
+    }
+  }
+
+  // Pass 2: attributes and faces
+  std::vector<tinyobj::real_t> v(3 * numV), vn(3 * numVn), vt(2 * numVt);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int c = 0; c < (int)numChunks; ++c)
+  {
+    ObjChunk &chunk = chunks[c];
+    size_t cv = chunk.baseV, cvn = chunk.baseVn, cvt = chunk.baseVt;
+    int faceMaterial = chunk.startMaterial;
+    std::string linebuf;
+    std::vector<tinyobj::vertex_index_t> face;
+    tinyobj::warning_context context;
+    context.warn = nullptr;
+    context.line_number = 0;
+
+    for_each_obj_line(chunk.begin, chunk.end, [&](const char* a_line, const char* a_lineEnd) {
+      linebuf.assign(a_line, a_lineEnd);
+      const char* token = linebuf.c_str();
+      token += strspn(token, " \t");
+      if (token[0] == '\0' || token[0] == '#')
+        return true;
+
+      if (token[0] == 'v' && IS_SPACE(token[1]))
+      {
+        token += 2;
+        tinyobj::real_t r, g, b;
+        tinyobj::parseVertexWithColor(&v[3 * cv + 0], &v[3 * cv + 1], &v[3 * cv + 2], &r, &g, &b, &token);
+        cv++;
+      }
+      else if (token[0] == 'v' && token[1] == 'n' && IS_SPACE(token[2]))
+      {
+        token += 3;
+        tinyobj::parseReal3(&vn[3 * cvn + 0], &vn[3 * cvn + 1], &vn[3 * cvn + 2], &token);
+        cvn++;
+      }
+      else if (token[0] == 'v' && token[1] == 't' && IS_SPACE(token[2]))
+      {
+        token += 3;
+        tinyobj::parseReal2(&vt[2 * cvt + 0], &vt[2 * cvt + 1], &token);
+        cvt++;
+      }
+      else if (token[0] == 'f' && IS_SPACE(token[1]))
+      {
+        token += 2;
+        token += strspn(token, " \t");
+        face.clear();
+        while (!IS_NEW_LINE(token[0]) && token[0] != '#')
+        {
+          tinyobj::vertex_index_t vi;
+          if (!tinyobj::parseTriple(&token, int(cv), int(cvn), int(cvt), &vi, context))
+          {
+            chunk.failed = true;
+            return false;
+          }
+          face.push_back(vi);
+          token += strspn(token, " \t\r");
+        }
+        if (face.size() < 3)
+          return true;  // degenerate face, skipped by tinyobj as well
+        if (face.size() > 4)
+        {
+          chunk.failed = true;
+          return false;
+        }
+        for (const tinyobj::vertex_index_t &vi : face)
+        {
+          tinyobj::index_t idx;
+          idx.vertex_index   = vi.v_idx;
+          idx.normal_index   = vi.vn_idx;
+          idx.texcoord_index = vi.vt_idx;
+          chunk.faceCorners.push_back(idx);
+        }
+        chunk.faceSizes.push_back((unsigned char)face.size());
+        chunk.faceMaterials.push_back(faceMaterial);
+        chunk.numTriangles += face.size() - 2;
+      }
+      else if (strncmp(token, "usemtl", 6) == 0)
+      {
+        token += 6;
+        auto it = materialMap.find(tinyobj::parseString(&token));
+        faceMaterial = (it != materialMap.end()) ? it->second : -1;
+      }
+      return true;
+    });
+  }
+
+  size_t numTriangles = 0;
+  for (ObjChunk &chunk : chunks)
+  {
+    if (chunk.failed)
+      return false;
+    chunk.baseTriangle = numTriangles;
+    numTriangles += chunk.numTriangles;
+  }
+  if (numTriangles == 0)
+    return false;
+
+  // Pass 3: triangulation into the global corner list
+  std::vector<tinyobj::index_t> corners(3 * numTriangles);
+  std::vector<int> triangleMaterials(numTriangles);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int c = 0; c < (int)numChunks; ++c)
+  {
+    ObjChunk &chunk = chunks[c];
+    const tinyobj::index_t* in = chunk.faceCorners.data();
+    size_t t = chunk.baseTriangle;
+    for (size_t f = 0; f < chunk.faceSizes.size(); ++f)
+    {
+      const int n = chunk.faceSizes[f];
+      for (int k = 0; k < n; ++k)
+      {
+        if (in[k].vertex_index < 0 || size_t(in[k].vertex_index) >= numV ||
+            in[k].normal_index >= int(numVn) || in[k].texcoord_index >= int(numVt))
+          chunk.failed = true;
+      }
+      if (chunk.failed)
+        break;
+
+      if (n == 3)
+      {
+        corners[3 * t + 0] = in[0];
+        corners[3 * t + 1] = in[1];
+        corners[3 * t + 2] = in[2];
+        triangleMaterials[t++] = chunk.faceMaterials[f];
+      }
+      else
+      {
+        // Split along the shorter diagonal, same arithmetic as tinyobj
+        const tinyobj::real_t* p0 = &v[3 * in[0].vertex_index];
+        const tinyobj::real_t* p1 = &v[3 * in[1].vertex_index];
+        const tinyobj::real_t* p2 = &v[3 * in[2].vertex_index];
+        const tinyobj::real_t* p3 = &v[3 * in[3].vertex_index];
+        tinyobj::real_t e02x = p2[0] - p0[0];
+        tinyobj::real_t e02y = p2[1] - p0[1];
+        tinyobj::real_t e02z = p2[2] - p0[2];
+        tinyobj::real_t e13x = p3[0] - p1[0];
+        tinyobj::real_t e13y = p3[1] - p1[1];
+        tinyobj::real_t e13z = p3[2] - p1[2];
+        tinyobj::real_t sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+        tinyobj::real_t sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+        const int split[2][6] = {{0, 1, 2, 0, 2, 3}, {0, 1, 3, 1, 2, 3}};
+        const int* order = split[sqr02 < sqr13 ? 0 : 1];
+        for (int k = 0; k < 6; ++k)
+          corners[3 * t + k] = in[order[k]];
+        triangleMaterials[t++] = chunk.faceMaterials[f];
+        triangleMaterials[t++] = chunk.faceMaterials[f];
+      }
+      in += n;
+    }
+  }
+  for (const ObjChunk &chunk : chunks)
+  {
+    if (chunk.failed)
+      return false;
+  }
+
+  // Dedup in corner order keeps the vertex order of the tinyobj path
+  mesh.indices.resize(corners.size());
+  std::vector<tinyobj::index_t> uniqueCorners;
+  uniqueCorners.reserve(numV);
+  VertexDedupTable uniqueVertIndices(corners.size());
+  for (size_t i = 0; i < corners.size(); ++i)
+  {
+    bool inserted = false;
+    mesh.indices[i] = uniqueVertIndices.FindOrInsert(corners[i], uint32_t(uniqueCorners.size()), inserted);
+    if (inserted)
+      uniqueCorners.push_back(corners[i]);
+  }
+
+  const LiteMath::float4 default_norm = float4(0, 0, 1, 0);
+  const LiteMath::float4 default_tangent = float4(1, 0, 0, 0);
+  const LiteMath::float2 default_texcoord = float2(0, 0);
+  const size_t numVerts = uniqueCorners.size();
+  mesh.vPos4f.resize(numVerts);
+  mesh.vNorm4f.resize(numVerts);
+  mesh.vTang4f.resize(numVerts);
+  mesh.vTexCoord2f.resize(numVerts);
+  #pragma omp parallel for
+  for (int i = 0; i < (int)numVerts; ++i)
+  {
+    const tinyobj::index_t &index = uniqueCorners[i];
+    mesh.vPos4f[i] = float4(v[3 * index.vertex_index + 0], v[3 * index.vertex_index + 1],
+                            v[3 * index.vertex_index + 2], 1.0f);
+    mesh.vNorm4f[i] = index.normal_index >= 0 ? float4(vn[3 * index.normal_index + 0], vn[3 * index.normal_index + 1],
+                                                       vn[3 * index.normal_index + 2], 0.0f)
+                                              : default_norm;
+    mesh.vTexCoord2f[i] = index.texcoord_index >= 0 ? float2(vt[2 * index.texcoord_index + 0],
+                                                             vt[2 * index.texcoord_index + 1])
+                                                    : default_texcoord;
+    mesh.vTang4f[i] = default_tangent;
+  }
+
+  mesh.matIndices.resize(numTriangles);
+  for (size_t t = 0; t < numTriangles; ++t)
+    mesh.matIndices[t] = triangleMaterials[t] < 0 ? 0 : unsigned(triangleMaterials[t]);
+
+  if (verbose)
+  {
+    printf("[LoadMeshFromObj::INFO] Loaded obj file %s with %d vertices and %d indices (%d chunks)\n",
+           a_fileName, (unsigned)mesh.vPos4f.size(), (unsigned)mesh.indices.size(), (int)numChunks);
+  }
+
+  fix_missing(mesh, 0);
+  assert(check_is_valid(mesh, true));
+  return true;
+}
+
+SimpleMesh LoadMeshFromObj(const char* a_fileName, bool verbose)
+{
+  if (verbose)
+    printf("[LoadMesh::INFO] Loading OBJ file %s\n", a_fileName);
+  SimpleMesh mesh;
+  if (LoadMeshFromObjParallel(a_fileName, mesh, verbose))
+    return mesh;
+  if (verbose)
+    printf("[LoadMeshFromObj::INFO] Using tinyobj for %s\n", a_fileName);
+  return LoadMeshFromObjTinyObj(a_fileName, verbose);
+}
+
+static const char MESH_BINARY_MAGIC[8] = {'C', 'M', 'E', 'S', 'H', '4', 'B', '\0'};
+
+static uint64_t align_up(uint64_t a_value)
+{
+  return (a_value + MESH_BINARY_ALIGNMENT - 1) / MESH_BINARY_ALIGNMENT * MESH_BINARY_ALIGNMENT;
+}
+
+// 64-bit multiply-xor hash over 8-byte words; a_size must be a multiple of 8
+// (streams are padded to MESH_BINARY_ALIGNMENT)
+static uint64_t binary_checksum(const unsigned char* a_data, uint64_t a_size, uint64_t a_hash = 0xcbf29ce484222325ULL)
+{
+  uint64_t h = a_hash;
+  for (uint64_t i = 0; i < a_size; i += 8)
+  {
+    uint64_t word;
+    memcpy(&word, a_data + i, 8);
+    h = (h ^ word) * 0x100000001b3ULL;
+    h ^= h >> 29;
+  }
+  return h;
+}
+
+static_assert(sizeof(MeshBinaryHeader) % 8 == 0, "binary_checksum hashes the header in 8-byte words");
+
+// Checksum of the header with its checksum field zeroed, followed by the streams
+static uint64_t mesh_checksum(const MeshBinaryHeader &a_header, const unsigned char* a_streams, uint64_t a_size)
+{
+  MeshBinaryHeader header = a_header;
+  header.checksum = 0;
+  return binary_checksum(a_streams, a_size, binary_checksum((const unsigned char*)&header, sizeof(header)));
+}
+
+static bool file_stamp(const char* a_fileName, uint64_t &a_size, int64_t &a_mtime)
+{
+  struct stat st;
+  if (stat(a_fileName, &st) != 0)
+    return false;
+  a_size  = (uint64_t)st.st_size;
+  a_mtime = (int64_t)st.st_mtime;
+  return true;
+}
+
+bool SaveMeshToBinary(const char* a_fileName, const SimpleMesh &mesh, uint64_t a_sourceSize, int64_t a_sourceMtime)
+{
+  MeshBinaryHeader header = {};
+  memcpy(header.magic, MESH_BINARY_MAGIC, sizeof(header.magic));
+  header.version       = MESH_BINARY_VERSION;
+  header.headerSize    = sizeof(MeshBinaryHeader);
+  header.sourceSize    = a_sourceSize;
+  header.sourceMtime   = a_sourceMtime;
+  header.vertexCount   = mesh.vPos4f.size();
+  header.indexCount    = mesh.indices.size();
+  header.triangleCount = mesh.matIndices.size();
+
+  const void* streams[6] = {mesh.vPos4f.data(), mesh.vNorm4f.data(), mesh.vTang4f.data(),
+                            mesh.vTexCoord2f.data(), mesh.indices.data(), mesh.matIndices.data()};
+  const uint64_t sizes[6] = {mesh.vPos4f.size()*sizeof(float)*4, mesh.vNorm4f.size()*sizeof(float)*4,
+                             mesh.vTang4f.size()*sizeof(float)*4, mesh.vTexCoord2f.size()*sizeof(float)*2,
+                             mesh.indices.size()*sizeof(unsigned int), mesh.matIndices.size()*sizeof(unsigned int)};
+  uint64_t offset = align_up(sizeof(MeshBinaryHeader));
+  for (int i = 0; i < 6; ++i)
+  {
+    header.streamOffset[i] = offset;
+    offset = align_up(offset + sizes[i]);
+  }
+  header.fileSize = offset;
+
+  std::vector<unsigned char> data(header.fileSize - header.streamOffset[0], 0);
+  for (int i = 0; i < 6; ++i)
+  {
+    if (sizes[i] > 0)
+      memcpy(data.data() + (header.streamOffset[i] - header.streamOffset[0]), streams[i], sizes[i]);
+  }
+  header.checksum = mesh_checksum(header, data.data(), data.size());
+
+  // Write to a temporary file and rename it, so readers never see a partially written mesh.
+  // The pid keeps processes that cache the same mesh from writing into one temporary file.
+#if defined(_WIN32)
+  const long pid = long(_getpid());
+#else
+  const long pid = long(getpid());
+#endif
+  const std::string tmpName = std::string(a_fileName) + "." + std::to_string(pid) + ".tmp";
+  std::ofstream out(tmpName, std::ios::binary);
+  if (!out)
+  {
+    printf("[SaveMeshToBinary::ERROR] Failed to create output file: %s\n", tmpName.c_str());
+    return false;
+  }
+  std::vector<unsigned char> headerBlock(header.streamOffset[0], 0);
+  memcpy(headerBlock.data(), &header, sizeof(header));
+  out.write((const char*)headerBlock.data(), headerBlock.size());
+  out.write((const char*)data.data(), data.size());
+  out.close();
+  if (!out)
+  {
+    printf("[SaveMeshToBinary::ERROR] Failed to write file: %s\n", tmpName.c_str());
+    remove(tmpName.c_str());
+    return false;
+  }
+#if defined(_WIN32)
+  remove(a_fileName); // rename does not replace an existing file here; POSIX rename does it atomically
+#endif
+  if (rename(tmpName.c_str(), a_fileName) != 0)
+  {
+    printf("[SaveMeshToBinary::ERROR] Failed to rename %s to %s\n", tmpName.c_str(), a_fileName);
+    remove(tmpName.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool MappedMesh::Open(const char* a_fileName, bool a_verifyChecksum)
+{
+  Close();
+#if !defined(_WIN32)
+  int fd = open(a_fileName, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MeshBinaryHeader))
+  {
+    close(fd);
+    return false;
+  }
+  void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (ptr == MAP_FAILED)
+    return false;
+  m_data   = (const unsigned char*)ptr;
+  m_size   = (size_t)st.st_size;
+  m_mapped = true;
+#else
+  std::ifstream in(a_fileName, std::ios::binary | std::ios::ate);
+  if (!in)
+    return false;
+  m_size = (size_t)in.tellg();
+  if (m_size < sizeof(MeshBinaryHeader))
+    return false;
+  unsigned char* buffer = new unsigned char[m_size];
+  in.seekg(0);
+  in.read((char*)buffer, m_size);
+  m_data   = buffer;
+  m_mapped = false;
+#endif
+
+  const MeshBinaryHeader &header = Header();
+  bool valid = memcmp(header.magic, MESH_BINARY_MAGIC, sizeof(header.magic)) == 0 &&
+               header.version == MESH_BINARY_VERSION &&
+               header.headerSize == sizeof(MeshBinaryHeader) &&
+               header.fileSize == m_size &&
+               header.fileSize % MESH_BINARY_ALIGNMENT == 0 &&
+               header.streamOffset[0] >= sizeof(MeshBinaryHeader);
+  for (int i = 0; i < 6 && valid; ++i)
+    valid = header.streamOffset[i] % MESH_BINARY_ALIGNMENT == 0 && header.streamOffset[i] <= m_size &&
+            (i == 0 || header.streamOffset[i] >= header.streamOffset[i - 1]);
+  if (valid)
+  {
+    // Each count is checked against the room left for its stream before any multiplication,
+    // so a corrupt count cannot wrap around and pass
+    const uint64_t counts[6]    = {header.vertexCount, header.vertexCount, header.vertexCount, header.vertexCount,
+                                   header.indexCount, header.triangleCount};
+    const uint64_t elemSizes[6] = {sizeof(float)*4, sizeof(float)*4, sizeof(float)*4, sizeof(float)*2,
+                                   sizeof(unsigned int), sizeof(unsigned int)};
+    for (int i = 0; i < 6 && valid; ++i)
+    {
+      const uint64_t end = (i < 5) ? header.streamOffset[i + 1] : m_size;
+      valid = counts[i] <= (end - header.streamOffset[i]) / elemSizes[i];
+    }
+  }
+  if (valid && a_verifyChecksum)
+    valid = mesh_checksum(header, m_data + header.streamOffset[0], m_size - header.streamOffset[0]) == header.checksum;
+  if (!valid)
+    Close();
+  return valid;
+}
+
+void MappedMesh::Close()
+{
+  if (m_data == nullptr)
+    return;
+#if !defined(_WIN32)
+  if (m_mapped)
+    munmap((void*)m_data, m_size);
+  else
+    delete[] m_data;
+#else
+  delete[] m_data;
+#endif
+  m_data = nullptr;
+  m_size = 0;
+  m_mapped = false;
+}
+
+SimpleMesh MappedMesh::ToSimpleMesh() const
+{
+  SimpleMesh mesh;
+  if (!IsOpen())
+    return mesh;
+  mesh.vPos4f.assign(Positions(), Positions() + VerticesNum());
+  mesh.vNorm4f.assign(Normals(), Normals() + VerticesNum());
+  mesh.vTang4f.assign(Tangents(), Tangents() + VerticesNum());
+  mesh.vTexCoord2f.assign(TexCoords(), TexCoords() + VerticesNum());
+  mesh.indices.assign(Indices(), Indices() + IndicesNum());
+  mesh.matIndices.assign(MatIndices(), MatIndices() + TrianglesNum());
+  return mesh;
+}
+
+bool LoadMeshFromBinary(const char* a_fileName, SimpleMesh &mesh, bool verbose)
+{
+  MappedMesh mapped;
+  if (!mapped.Open(a_fileName))
+  {
+    if (verbose)
+      printf("[LoadMeshFromBinary::ERROR] Missing or invalid binary mesh file: %s\n", a_fileName);
+    return false;
+  }
+  mesh = mapped.ToSimpleMesh();
+  if (verbose)
+    printf("[LoadMeshFromBinary::INFO] Loaded binary mesh %s with %d vertices and %d indices\n",
+           a_fileName, (unsigned)mesh.vPos4f.size(), (unsigned)mesh.indices.size());
+  return true;
+}
+
+SimpleMesh LoadMeshFromObjCached(const char* a_fileName, bool verbose)
+{
+  const std::string cacheName = std::string(a_fileName) + ".cmesh";
+  uint64_t sourceSize = 0;
+  int64_t  sourceMtime = 0;
+  if (!file_stamp(a_fileName, sourceSize, sourceMtime))
+    return LoadMeshFromObj(a_fileName, verbose);
+
+  MappedMesh mapped;
+  if (mapped.Open(cacheName.c_str()))
+  {
+    if (mapped.Header().sourceSize == sourceSize && mapped.Header().sourceMtime == sourceMtime)
+    {
+      if (verbose)
+        printf("[LoadMeshFromObjCached::INFO] Using binary cache %s\n", cacheName.c_str());
+      return mapped.ToSimpleMesh();
+    }
+    if (verbose)
+      printf("[LoadMeshFromObjCached::INFO] Binary cache %s is out of date\n", cacheName.c_str());
+    mapped.Close();
+  }
+
+  SimpleMesh mesh = LoadMeshFromObj(a_fileName, verbose);
+  if (mesh.TrianglesNum() > 0)
+    SaveMeshToBinary(cacheName.c_str(), mesh, sourceSize, sourceMtime);
+  return mesh;
+}
+
+// IEEE 754 binary16 conversion, round to nearest even
+static uint16_t float_to_half(float a_value)
+{
+  uint32_t f;
+  memcpy(&f, &a_value, sizeof(f));
+  const uint32_t sign = (f >> 16) & 0x8000u;
+  const uint32_t absf = f & 0x7FFFFFFFu;
+  if (absf >= 0x7F800000u)                                  // inf, nan
+    return uint16_t(sign | 0x7C00u | (absf > 0x7F800000u ? 0x200u : 0u));
+  if (absf >= 0x477FF000u)                                  // rounds to >= 65520, overflow
+    return uint16_t(sign | 0x7C00u);
+  if (absf < 0x38800000u)                                   // half denormal or zero
+  {
+    if (absf < 0x33000000u)
+      return uint16_t(sign);
+    const uint32_t exponent = absf >> 23;
+    const uint32_t mantissa = (absf & 0x007FFFFFu) | 0x00800000u;
+    const uint32_t shift = 126 - exponent;                  // 14..24
+    uint32_t half = mantissa >> shift;
+    const uint32_t rest = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1)))
+      half++;
+    return uint16_t(sign | half);
+  }
+  uint32_t half = ((absf - 0x38000000u) >> 13);             // rebias exponent 127 -> 15
+  const uint32_t rest = absf & 0x1FFFu;
+  if (rest > 0x1000u || (rest == 0x1000u && (half & 1)))
+    half++;
+  return uint16_t(sign | half);
+}
+
+static float half_to_float(uint16_t a_half)
+{
+  const uint32_t sign = uint32_t(a_half & 0x8000u) << 16;
+  const uint32_t exponent = (a_half >> 10) & 0x1Fu;
+  uint32_t mantissa = a_half & 0x3FFu;
+  uint32_t f;
+  if (exponent == 0x1Fu)
+    f = sign | 0x7F800000u | (mantissa << 13);
+  else if (exponent != 0)
+    f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  else if (mantissa == 0)
+    f = sign;
+  else
+  {
+    uint32_t e = 113;
+    while ((mantissa & 0x400u) == 0)
+    {
+      mantissa <<= 1;
+      e--;
+    }
+    f = sign | (e << 23) | ((mantissa & 0x3FFu) << 13);
+  }
+  float value;
+  memcpy(&value, &f, sizeof(value));
+  return value;
+}
+
+static int16_t to_snorm16(float a_value)
+{
+  return int16_t(roundf(LiteMath::clamp(a_value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// Octahedral mapping of a unit vector to [-1,1]^2 packed into two snorm16.
+// A zero vector is stored as (0,0,1).
+static uint32_t encode_octahedral(const float4 &a_dir)
+{
+  const float len1 = fabsf(a_dir.x) + fabsf(a_dir.y) + fabsf(a_dir.z);
+  if (len1 <= 0.0f)
+    return 0;
+  float x = a_dir.x / len1;
+  float y = a_dir.y / len1;
+  if (a_dir.z < 0.0f)
+  {
+    const float ox = x;
+    x = (1.0f - fabsf(y)) * (ox >= 0.0f ? 1.0f : -1.0f);
+    y = (1.0f - fabsf(ox)) * (y >= 0.0f ? 1.0f : -1.0f);
+  }
+  return uint32_t(uint16_t(to_snorm16(x))) | (uint32_t(uint16_t(to_snorm16(y))) << 16);
+}
+
+static float4 decode_octahedral(uint32_t a_oct)
+{
+  const float x = std::max(float(int16_t(a_oct & 0xFFFFu)) / 32767.0f, -1.0f);
+  const float y = std::max(float(int16_t(a_oct >> 16)) / 32767.0f, -1.0f);
+  float4 dir(x, y, 1.0f - fabsf(x) - fabsf(y), 0.0f);
+  const float t = std::max(-dir.z, 0.0f);
+  dir.x += (dir.x >= 0.0f) ? -t : t;
+  dir.y += (dir.y >= 0.0f) ? -t : t;
+  const float len = sqrtf(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+  return float4(dir.x / len, dir.y / len, dir.z / len, 0.0f);
+}
+
+static const float4 COMPACT_DEFAULT_NORMAL  = float4(0, 0, 1, 0);
+static const float4 COMPACT_DEFAULT_TANGENT = float4(1, 0, 0, 0);
+
+static bool same_xyz(const float4 &a, const float4 &b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+CompactMesh CompactMeshFromSimpleMesh(const SimpleMesh &mesh, uint32_t a_streams)
+{
+  CompactMesh compact;
+  const int numVerts = int(mesh.VerticesNum());
+  const int numIndices = int(mesh.IndicesNum());
+  const int numTris = int(mesh.TrianglesNum());
+
+  // Bounds and the streams that carry something besides the defaults. A stream shorter than
+  // the vertex (or triangle) count cannot be encoded for every element and is dropped.
+  const bool fullNormals   = mesh.vNorm4f.size() >= size_t(numVerts);
+  const bool fullTangents  = mesh.vTang4f.size() >= size_t(numVerts);
+  const bool fullTexCoords = mesh.vTexCoord2f.size() >= size_t(numVerts);
+  const bool fullMaterials = mesh.matIndices.size() >= size_t(numTris);
+  float4 boundsMin = float4(FLT_MAX, FLT_MAX, FLT_MAX, 1.0f);
+  float4 boundsMax = float4(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0f);
+  bool hasNormals = false, hasTangents = false, hasTexCoords = false, hasMaterials = false;
+  #pragma omp parallel
+  {
+    float4 localMin = boundsMin, localMax = boundsMax;
+    bool n = false, t = false, uv = false;
+    #pragma omp for nowait
+    for (int i = 0; i < numVerts; ++i)
+    {
+      localMin = LiteMath::min(localMin, mesh.vPos4f[i]);
+      localMax = LiteMath::max(localMax, mesh.vPos4f[i]);
+      n  |= fullNormals && !same_xyz(mesh.vNorm4f[i], COMPACT_DEFAULT_NORMAL);
+      t  |= fullTangents && !same_xyz(mesh.vTang4f[i], COMPACT_DEFAULT_TANGENT);
+      uv |= fullTexCoords && (mesh.vTexCoord2f[i].x != 0.0f || mesh.vTexCoord2f[i].y != 0.0f);
+    }
+    #pragma omp critical
+    {
+      boundsMin = LiteMath::min(boundsMin, localMin);
+      boundsMax = LiteMath::max(boundsMax, localMax);
+      hasNormals |= n;
+      hasTangents |= t;
+      hasTexCoords |= uv;
+    }
+  }
+  for (int i = 0; fullMaterials && i < numTris && !hasMaterials; ++i)
+    hasMaterials = mesh.matIndices[i] != 0;
+
+  if (numVerts == 0)
+    boundsMin = boundsMax = float4(0, 0, 0, 1);
+  compact.boundsMin = float4(boundsMin.x, boundsMin.y, boundsMin.z, 1.0f);
+  compact.boundsMax = float4(boundsMax.x, boundsMax.y, boundsMax.z, 1.0f);
+  compact.streams = (hasNormals   ? COMPACT_STREAM_NORMALS   : 0) |
+                    (hasTangents  ? COMPACT_STREAM_TANGENTS  : 0) |
+                    (hasTexCoords ? COMPACT_STREAM_TEXCOORDS : 0) |
+                    (hasMaterials ? COMPACT_STREAM_MATERIALS : 0);
+  compact.streams &= a_streams;
+
+  compact.vPos3u16.resize(3 * size_t(numVerts));
+  if (compact.HasStream(COMPACT_STREAM_NORMALS))
+    compact.vNormOct.resize(numVerts);
+  if (compact.HasStream(COMPACT_STREAM_TANGENTS))
+    compact.vTangOct.resize(numVerts);
+  if (compact.HasStream(COMPACT_STREAM_TEXCOORDS))
+    compact.vTexCoord2h.resize(numVerts);
+
+  const float4 extent = compact.boundsMax - compact.boundsMin;
+  const float scale[3] = {extent.x > 0.0f ? 65535.0f / extent.x : 0.0f,
+                          extent.y > 0.0f ? 65535.0f / extent.y : 0.0f,
+                          extent.z > 0.0f ? 65535.0f / extent.z : 0.0f};
+  #pragma omp parallel for
+  for (int i = 0; i < numVerts; ++i)
+  {
+    const float4 &p = mesh.vPos4f[i];
+    for (int a = 0; a < 3; ++a)
+    {
+      const float q = roundf((p[a] - compact.boundsMin[a]) * scale[a]);
+      compact.vPos3u16[3 * i + a] = uint16_t(LiteMath::clamp(q, 0.0f, 65535.0f));
+    }
+    if (!compact.vNormOct.empty())
+      compact.vNormOct[i] = encode_octahedral(mesh.vNorm4f[i]);
+    if (!compact.vTangOct.empty())
+      compact.vTangOct[i] = encode_octahedral(mesh.vTang4f[i]);
+    if (!compact.vTexCoord2h.empty())
+      compact.vTexCoord2h[i] = uint32_t(float_to_half(mesh.vTexCoord2f[i].x)) |
+                               (uint32_t(float_to_half(mesh.vTexCoord2f[i].y)) << 16);
+  }
+
+  if (numVerts <= 65536)
+  {
+    compact.indices16.resize(numIndices);
+    #pragma omp parallel for
+    for (int i = 0; i < numIndices; ++i)
+      compact.indices16[i] = uint16_t(mesh.indices[i]);
+  }
+  else
+    compact.indices32.assign(mesh.indices.begin(), mesh.indices.end());
+
+  if (compact.HasStream(COMPACT_STREAM_MATERIALS))
+  {
+    // Ids that do not fit 16 bits are clamped to the last one instead of wrapping around
+    int clamped = 0;
+    compact.matIndices.resize(numTris);
+    for (int i = 0; i < numTris; ++i)
+    {
+      clamped += mesh.matIndices[i] > 65535u;
+      compact.matIndices[i] = uint16_t(std::min(mesh.matIndices[i], 65535u));
+    }
+    if (clamped > 0)
+      printf("[CompactMeshFromSimpleMesh::WARNING] %d material ids above 65535 clamped to 65535\n", clamped);
+  }
+  return compact;
+}
+
+float4 CompactMesh::Position(size_t a_vert) const
+{
+  const float4 step = (boundsMax - boundsMin) * (1.0f / 65535.0f);
+  return float4(boundsMin.x + float(vPos3u16[3 * a_vert + 0]) * step.x,
+                boundsMin.y + float(vPos3u16[3 * a_vert + 1]) * step.y,
+                boundsMin.z + float(vPos3u16[3 * a_vert + 2]) * step.z, 1.0f);
+}
+
+float4 CompactMesh::Normal(size_t a_vert) const
+{
+  return vNormOct.empty() ? COMPACT_DEFAULT_NORMAL : decode_octahedral(vNormOct[a_vert]);
+}
+
+float4 CompactMesh::Tangent(size_t a_vert) const
+{
+  return vTangOct.empty() ? COMPACT_DEFAULT_TANGENT : decode_octahedral(vTangOct[a_vert]);
+}
+
+float2 CompactMesh::TexCoord(size_t a_vert) const
+{
+  if (vTexCoord2h.empty())
+    return float2(0, 0);
+  return float2(half_to_float(uint16_t(vTexCoord2h[a_vert] & 0xFFFFu)), half_to_float(uint16_t(vTexCoord2h[a_vert] >> 16)));
+}
+
+SimpleMesh CompactMesh::ToSimpleMesh() const
+{
+  SimpleMesh mesh(VerticesNum(), IndicesNum());
+  #pragma omp parallel for
+  for (int i = 0; i < int(VerticesNum()); ++i)
+  {
+    mesh.vPos4f[i]      = Position(i);
+    mesh.vNorm4f[i]     = Normal(i);
+    mesh.vTang4f[i]     = Tangent(i);
+    mesh.vTexCoord2f[i] = TexCoord(i);
+  }
+  #pragma omp parallel for
+  for (int i = 0; i < int(IndicesNum()); ++i)
+    mesh.indices[i] = Index(i);
+  for (size_t i = 0; i < mesh.matIndices.size(); ++i)
+    mesh.matIndices[i] = MatIndex(i);
+  return mesh;
+}
 } // namespace cmesh4
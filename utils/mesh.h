@@ -55,4 +55,138 @@ namespace cmesh4
 
   void SaveMeshToObj(const char* a_fileName, const cmesh4::SimpleMesh &mesh);
   SimpleMesh LoadMeshFromObj(const char* a_fileName, bool verbose = false);
+
+  // Binary mesh file: fixed header followed by the SimpleMesh streams (positions, normals,
+  // tangents, texcoords, indices, material ids), each starting at a MESH_BINARY_ALIGNMENT
+  // offset, so the file can be memory-mapped and its streams used in place.
+  // sourceSize/sourceMtime describe the file the mesh was built from and are used to
+  // invalidate caches; checksum covers the header (with the checksum field zeroed) and
+  // everything after it.
+  static const uint64_t MESH_BINARY_ALIGNMENT = 64;
+  static const uint32_t MESH_BINARY_VERSION   = 2;
+
+  struct MeshBinaryHeader
+  {
+    char     magic[8];        // "CMESH4B\0"
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sourceSize;
+    int64_t  sourceMtime;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t triangleCount;
+    uint64_t streamOffset[6]; // pos, norm, tang, texcoord, indices, matIndices
+    uint64_t fileSize;
+    uint64_t checksum;
+  };
+
+  // Read-only memory-mapped view of a binary mesh file; pointers stay valid until Close()
+  struct MappedMesh
+  {
+    MappedMesh() {}
+    ~MappedMesh() { Close(); }
+    MappedMesh(const MappedMesh &other) = delete;
+    MappedMesh &operator=(const MappedMesh &other) = delete;
+
+    bool Open(const char* a_fileName, bool a_verifyChecksum = true);
+    void Close();
+
+    inline bool   IsOpen()       const { return m_data != nullptr; }
+    inline size_t VerticesNum()  const { return IsOpen() ? Header().vertexCount : 0; }
+    inline size_t IndicesNum()   const { return IsOpen() ? Header().indexCount : 0; }
+    inline size_t TrianglesNum() const { return IsOpen() ? Header().triangleCount : 0; }
+    inline const MeshBinaryHeader &Header() const { return *reinterpret_cast<const MeshBinaryHeader*>(m_data); }
+
+    inline const LiteMath::float4 *Positions() const { return Stream<LiteMath::float4>(0); }
+    inline const LiteMath::float4 *Normals()   const { return Stream<LiteMath::float4>(1); }
+    inline const LiteMath::float4 *Tangents()  const { return Stream<LiteMath::float4>(2); }
+    inline const LiteMath::float2 *TexCoords() const { return Stream<LiteMath::float2>(3); }
+    inline const unsigned int     *Indices()   const { return Stream<unsigned int>(4); }
+    inline const unsigned int     *MatIndices() const { return Stream<unsigned int>(5); }
+
+    SimpleMesh ToSimpleMesh() const;
+
+  private:
+    template<typename T>
+    const T *Stream(int a_stream) const
+    {
+      return IsOpen() ? reinterpret_cast<const T*>(m_data + Header().streamOffset[a_stream]) : nullptr;
+    }
+
+    const unsigned char *m_data = nullptr;
+    size_t m_size = 0;
+    bool   m_mapped = false;  // false if the file was read into memory (no mmap on this platform)
+  };
+
+  bool SaveMeshToBinary(const char* a_fileName, const cmesh4::SimpleMesh &mesh,
+                        uint64_t a_sourceSize = 0, int64_t a_sourceMtime = 0);
+  bool LoadMeshFromBinary(const char* a_fileName, SimpleMesh &mesh, bool verbose = false);
+
+  // Compact (lossy) mesh for large meshes: positions quantized to 16 bits per axis inside
+  // [boundsMin, boundsMax], normals and tangents octahedral-encoded into two 16-bit snorms,
+  // texcoords as two half floats, 16-bit indices while the vertex count allows it and 16-bit
+  // material ids. Optional streams are allocated only when the source mesh has something
+  // other than the loader defaults in them (normal (0,0,1), tangent (1,0,0), texcoord (0,0),
+  // material 0); decoding an absent stream gives the default back. Tangent w is not stored.
+  // Typical size is 18 bytes per vertex against 56 bytes in SimpleMesh.
+  static const uint32_t COMPACT_STREAM_NORMALS   = 1;
+  static const uint32_t COMPACT_STREAM_TANGENTS  = 2;
+  static const uint32_t COMPACT_STREAM_TEXCOORDS = 4;
+  static const uint32_t COMPACT_STREAM_MATERIALS = 8;
+  static const uint32_t COMPACT_STREAMS_AUTO     = 0xFFFFFFFF;
+
+  struct CompactMesh
+  {
+    inline size_t VerticesNum()  const { return vPos3u16.size() / 3; }
+    inline size_t IndicesNum()   const { return indices16.empty() ? indices32.size() : indices16.size(); }
+    inline size_t TrianglesNum() const { return IndicesNum() / SimpleMesh::POINTS_IN_TRIANGLE; }
+    inline bool   HasStream(uint32_t a_stream) const { return (streams & a_stream) != 0; }
+
+    inline unsigned int Index(size_t a_index) const
+    {
+      return indices16.empty() ? indices32[a_index] : indices16[a_index];
+    }
+
+    inline size_t SizeInBytes() const
+    {
+      return vPos3u16.size()*sizeof(uint16_t) +
+             vNormOct.size()*sizeof(uint32_t) +
+             vTangOct.size()*sizeof(uint32_t) +
+             vTexCoord2h.size()*sizeof(uint32_t) +
+             indices16.size()*sizeof(uint16_t) +
+             indices32.size()*sizeof(uint32_t) +
+             matIndices.size()*sizeof(uint16_t);
+    }
+
+    // Largest per-axis position error introduced by the quantization
+    LiteMath::float4 PositionError() const { return (boundsMax - boundsMin) * (0.5f / 65535.0f); }
+
+    LiteMath::float4 Position(size_t a_vert) const;
+    LiteMath::float4 Normal(size_t a_vert) const;
+    LiteMath::float4 Tangent(size_t a_vert) const;
+    LiteMath::float2 TexCoord(size_t a_vert) const;
+    unsigned int     MatIndex(size_t a_tri) const { return matIndices.empty() ? 0 : matIndices[a_tri]; }
+
+    SimpleMesh ToSimpleMesh() const;
+
+    LiteMath::float4      boundsMin = LiteMath::float4(0, 0, 0, 1);
+    LiteMath::float4      boundsMax = LiteMath::float4(0, 0, 0, 1);
+    uint32_t              streams = 0;  // COMPACT_STREAM_* present in this mesh
+    std::vector<uint16_t> vPos3u16;     // 3 per vertex, unorm16 relative to the bounds
+    std::vector<uint32_t> vNormOct;     // 2 x snorm16 octahedral, optional
+    std::vector<uint32_t> vTangOct;     // 2 x snorm16 octahedral, optional
+    std::vector<uint32_t> vTexCoord2h;  // 2 x half, optional
+    std::vector<uint16_t> indices16;    // used when VerticesNum() <= 65536
+    std::vector<uint32_t> indices32;    // used otherwise
+    std::vector<uint16_t> matIndices;   // 1 per triangle, optional
+  };
+
+  // a_streams limits the optional streams that are kept; with COMPACT_STREAMS_AUTO every stream
+  // that differs from the defaults is kept. Streams shorter than the vertex or triangle count are
+  // dropped; material ids above 65535 are clamped to 65535.
+  CompactMesh CompactMeshFromSimpleMesh(const SimpleMesh &mesh, uint32_t a_streams = COMPACT_STREAMS_AUTO);
+
+  // Same as LoadMeshFromObj, but keeps a binary copy next to the .obj (a_fileName + ".cmesh")
+  // and loads it instead of parsing while the .obj size and modification time are unchanged.
+  SimpleMesh LoadMeshFromObjCached(const char* a_fileName, bool verbose = false);
 };
@@ -0,0 +1,556 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/mesh.h"
+#include "utils/voxel_world.h"
+
+#include <omp.h>
+#include <cstdint>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using LiteMath::float3;
+using LiteMath::float4;
+
+// ============ BVH ПО ТРЕУГОЛЬНИКАМ МЕША ============
+// Меши (cmesh4::SimpleMesh в мировых координатах) трассируются напрямую, без
+// вокселизации, и попадания сливаются с rayCast воксельного мира по
+// ближайшему t (см. shadeRayWithMeshes в voxel_render.h).
+//
+// Построение: бинарное дерево по SAH с MESH_BVH_BINS корзинами по каждой оси.
+// Верхние узлы (больше MESH_BVH_PARALLEL_PRIMS треугольников) строятся по
+// очереди с параллельным разбиением по корзинам, оставшиеся поддеревья -
+// параллельно, каждое одним потоком. Результат не зависит от числа потоков.
+// Затем бинарное дерево сворачивается в 4-арное: узел хранит AABB четырех
+// потомков покомпонентно (SoA), так что тест луча сразу с четырьмя коробками
+// - один векторизуемый цикл.
+static constexpr int MESH_BVH_BINS           = 16;
+static constexpr int MESH_BVH_MAX_LEAF       = 8;     // больше - лист делится всегда
+static constexpr int MESH_BVH_PARALLEL_PRIMS = 16384;
+static constexpr int MESH_BVH_STACK          = 64;    // стек обхода на стеке потока; глубже - в куче
+
+// Узел 4-арного дерева. child >= 0 и count == 0 - внутренний узел,
+// count > 0 - лист с треугольниками [child, child + count), child < 0 - пусто
+// (слэб-тест с min/max по осям вывернутую коробку не отсекает, поэтому пустые
+// слоты отбрасываются по child).
+struct alignas(32) MeshBVHNode {
+    float minX[4], minY[4], minZ[4];
+    float maxX[4], maxY[4], maxZ[4];
+    int32_t  child[4];
+    uint32_t count[4];
+};
+
+struct MeshHit {
+    float  t = FLT_MAX;
+    float3 normal;          // нормаль в точке, развернута к лучу
+    Voxel  voxel;           // материал треугольника
+    uint32_t triangle = 0;  // индекс треугольника в исходном меше
+};
+
+class MeshBVH {
+public:
+    // materials[i] - воксель (номер материала) для материала i меша; материалы вне
+    // таблицы берут materials[0] или камень, если таблица пуста
+    void build(const cmesh4::SimpleMesh& mesh, const std::vector<Voxel>& materials = {});
+
+    bool intersect(const float3& origin, const float3& dir, float tMax, MeshHit& hit) const;
+    // Есть ли хоть одно попадание на (0, tMax): без сортировки потомков и нормалей
+    bool occluded(const float3& origin, const float3& dir, float tMax) const;
+
+    bool   empty()         const { return nodes_.empty(); }
+    size_t nodeCount()     const { return nodes_.size(); }
+    int    depth()         const { return depth_; }
+    size_t triangleCount() const { return triV0_.size(); }
+    float3 boundsMin()     const { return boundsMin_; }
+    float3 boundsMax()     const { return boundsMax_; }
+
+    size_t getMemoryUsage() const {
+        return nodes_.size() * sizeof(MeshBVHNode) +
+               (triV0_.size() + triE1_.size() + triE2_.size() + triNormals_.size()) * sizeof(float3) +
+               triMaterial_.size() * sizeof(uint32_t) + triIndex_.size() * sizeof(uint32_t) +
+               materials_.size() * sizeof(Voxel);
+    }
+
+private:
+    struct AABB {
+        float3 mn = float3(FLT_MAX);
+        float3 mx = float3(-FLT_MAX);
+        void grow(const float3& p)  { mn = LiteMath::min(mn, p); mx = LiteMath::max(mx, p); }
+        void grow(const AABB& b)    { mn = LiteMath::min(mn, b.mn); mx = LiteMath::max(mx, b.mx); }
+        float area() const {
+            if (mn.x > mx.x) return 0.0f;
+            const float3 e = mx - mn;
+            return e.x * e.y + e.y * e.z + e.z * e.x;
+        }
+    };
+
+    // Узел бинарного дерева: left/right - индексы потомков, либо лист [first, first + count)
+    struct BuildNode {
+        AABB     bounds;
+        int32_t  left = -1, right = -1;
+        uint32_t first = 0, count = 0;
+    };
+
+    struct BuildContext {
+        std::vector<AABB>     primBounds;
+        std::vector<float3>   centroids;
+        std::vector<uint32_t> prims;
+    };
+
+    struct Split {
+        int   axis = -1;
+        int   bin = 0;          // потомок слева - корзины [0, bin]
+        float cost = FLT_MAX;
+        float scale = 0.0f;     // перевод центроида в номер корзины
+        float offset = 0.0f;
+    };
+
+    static Split findSplit(const BuildContext& ctx, uint32_t first, uint32_t count,
+                           const AABB& centroidBounds, bool parallel);
+    static uint32_t partition(BuildContext& ctx, uint32_t first, uint32_t count, const Split& split);
+    static void buildSubtree(BuildContext& ctx, std::vector<BuildNode>& nodes, int32_t node);
+    static bool splitNode(BuildContext& ctx, std::vector<BuildNode>& nodes, int32_t node, bool parallel);
+    void collapse(const std::vector<BuildNode>& nodes, int32_t node, int32_t out, int depth);
+    // Снятие узла кладет не больше 3 новых сверх него, так что стеку хватает 3 * depth_ + 1
+    size_t stackSize() const { return 3 * (size_t)depth_ + 1; }
+
+    std::vector<MeshBVHNode> nodes_;
+    // Треугольники в порядке листьев: v0, ребра e1 = v1 - v0, e2 = v2 - v0
+    std::vector<float3>   triV0_, triE1_, triE2_;
+    std::vector<float3>   triNormals_;      // 3 нормали вершин на треугольник (если есть в меше)
+    std::vector<uint32_t> triMaterial_;
+    std::vector<uint32_t> triIndex_;
+    std::vector<Voxel>    materials_;
+    int    depth_ = 0;                      // число уровней внутренних узлов 4-арного дерева
+    float3 boundsMin_ = float3(0.0f), boundsMax_ = float3(0.0f);
+};
+
+// ---------- построение ----------
+
+inline MeshBVH::Split MeshBVH::findSplit(const BuildContext& ctx, uint32_t first, uint32_t count,
+                                          const AABB& centroidBounds, bool parallel) {
+    struct Bin { AABB bounds; uint32_t count = 0; };
+    Bin bins[3][MESH_BVH_BINS];
+    float scale[3], offset[3];
+    for (int a = 0; a < 3; a++) {
+        const float extent = centroidBounds.mx[a] - centroidBounds.mn[a];
+        scale[a]  = extent > 0.0f ? MESH_BVH_BINS * (1.0f - 1e-5f) / extent : 0.0f;
+        if (!std::isfinite(scale[a])) scale[a] = 0.0f;     // денормальный разброс: 0 * inf дал бы NaN-корзину
+        offset[a] = centroidBounds.mn[a];
+    }
+
+    auto binRange = [&](uint32_t begin, uint32_t end, Bin* out) {   // out[axis * MESH_BVH_BINS + bin]
+        for (uint32_t i = begin; i < end; i++) {
+            const uint32_t p = ctx.prims[i];
+            for (int a = 0; a < 3; a++) {
+                const int b = std::min(MESH_BVH_BINS - 1, (int)((ctx.centroids[p][a] - offset[a]) * scale[a]));
+                out[a * MESH_BVH_BINS + b].bounds.grow(ctx.primBounds[p]);
+                out[a * MESH_BVH_BINS + b].count++;
+            }
+        }
+    };
+
+    if (parallel) {
+        // Каждый поток бинирует свой кусок, затем корзины складываются по порядку
+        std::vector<Bin> threadBins((size_t)omp_get_max_threads() * 3 * MESH_BVH_BINS);
+        #pragma omp parallel
+        {
+            const uint32_t threads = (uint32_t)omp_get_num_threads();
+            const uint32_t t = (uint32_t)omp_get_thread_num();
+            binRange(first + (uint32_t)((uint64_t)count * t / threads),
+                     first + (uint32_t)((uint64_t)count * (t + 1) / threads), &threadBins[t * 3 * MESH_BVH_BINS]);
+        }
+        for (size_t i = 0; i < threadBins.size(); i++) {
+            Bin& bin = bins[(i / MESH_BVH_BINS) % 3][i % MESH_BVH_BINS];
+            bin.bounds.grow(threadBins[i].bounds);
+            bin.count += threadBins[i].count;
+        }
+    } else {
+        binRange(first, first + count, &bins[0][0]);
+    }
+
+    // SAH: стоимость разреза пропорциональна площадям и числу треугольников сторон
+    Split best;
+    for (int a = 0; a < 3; a++) {
+        if (scale[a] == 0.0f) continue;
+        float rightArea[MESH_BVH_BINS];
+        uint32_t rightCount[MESH_BVH_BINS];
+        AABB box;
+        uint32_t n = 0;
+        for (int b = MESH_BVH_BINS - 1; b > 0; b--) {
+            box.grow(bins[a][b].bounds);
+            n += bins[a][b].count;
+            rightArea[b] = box.area();
+            rightCount[b] = n;
+        }
+        box = AABB();
+        n = 0;
+        for (int b = 0; b < MESH_BVH_BINS - 1; b++) {
+            box.grow(bins[a][b].bounds);
+            n += bins[a][b].count;
+            if (n == 0 || rightCount[b + 1] == 0) continue;
+            const float cost = box.area() * n + rightArea[b + 1] * rightCount[b + 1];
+            if (cost < best.cost) {
+                best.axis = a;
+                best.bin = b;
+                best.cost = cost;
+                best.scale = scale[a];
+                best.offset = offset[a];
+            }
+        }
+    }
+    return best;
+}
+
+inline uint32_t MeshBVH::partition(BuildContext& ctx, uint32_t first, uint32_t count, const Split& split) {
+    uint32_t* begin = ctx.prims.data() + first;
+    uint32_t* mid = std::stable_partition(begin, begin + count, [&](uint32_t p) {
+        const int b = std::min(MESH_BVH_BINS - 1, (int)((ctx.centroids[p][split.axis] - split.offset) * split.scale));
+        return b <= split.bin;
+    });
+    return (uint32_t)(mid - begin);
+}
+
+// Делит лист node на двух потомков, если это выгодно по SAH. false - узел остается листом.
+inline bool MeshBVH::splitNode(BuildContext& ctx, std::vector<BuildNode>& nodes, int32_t node, bool parallel) {
+    const uint32_t first = nodes[node].first;
+    const uint32_t count = nodes[node].count;
+    if (count <= 2) return false;
+
+    AABB centroidBounds;
+    for (uint32_t i = first; i < first + count; i++) centroidBounds.grow(ctx.centroids[ctx.prims[i]]);
+
+    Split split = findSplit(ctx, first, count, centroidBounds, parallel);
+    uint32_t leftCount = 0;
+    if (split.axis >= 0) {
+        // Стоимость листа - count пересечений, разреза - обход узла плюс пересечения в потомках
+        const float leafCost = (float)count;
+        const float splitCost = 1.0f + split.cost / std::max(nodes[node].bounds.area(), 1e-20f);
+        if (splitCost >= leafCost && count <= MESH_BVH_MAX_LEAF) return false;
+        leftCount = partition(ctx, first, count, split);
+    } else {
+        // Все центроиды совпадают: делим пополам по индексу
+        if (count <= MESH_BVH_MAX_LEAF) return false;
+        leftCount = count / 2;
+    }
+
+    BuildNode left, right;
+    left.first = first;
+    left.count = leftCount;
+    right.first = first + leftCount;
+    right.count = count - leftCount;
+    for (uint32_t i = left.first; i < left.first + left.count; i++) left.bounds.grow(ctx.primBounds[ctx.prims[i]]);
+    for (uint32_t i = right.first; i < right.first + right.count; i++) right.bounds.grow(ctx.primBounds[ctx.prims[i]]);
+
+    nodes[node].left = (int32_t)nodes.size();
+    nodes.push_back(left);
+    nodes[node].right = (int32_t)nodes.size();
+    nodes.push_back(right);
+    return true;
+}
+
+inline void MeshBVH::buildSubtree(BuildContext& ctx, std::vector<BuildNode>& nodes, int32_t root) {
+    std::vector<int32_t> stack = {root};
+    while (!stack.empty()) {
+        const int32_t node = stack.back();
+        stack.pop_back();
+        if (splitNode(ctx, nodes, node, false)) {
+            stack.push_back(nodes[node].right);
+            stack.push_back(nodes[node].left);
+        }
+    }
+}
+
+// Переносит потомков бинарного узла node в 4-арный узел out: раскрываем
+// внутреннего потомка с наибольшей площадью, пока слотов не станет 4.
+// depth - уровень out (корень - 1), наибольший запоминается в depth_.
+inline void MeshBVH::collapse(const std::vector<BuildNode>& nodes, int32_t node, int32_t out, int depth) {
+    depth_ = std::max(depth_, depth);
+    int32_t slots[4] = {nodes[node].left, nodes[node].right, -1, -1};
+    int used = 2;
+    while (used < 4) {
+        int best = -1;
+        float bestArea = -1.0f;
+        for (int i = 0; i < used; i++) {
+            const BuildNode& c = nodes[slots[i]];
+            if (c.left >= 0 && c.bounds.area() > bestArea) { best = i; bestArea = c.bounds.area(); }
+        }
+        if (best < 0) break;
+        const int32_t expanded = slots[best];
+        slots[best] = nodes[expanded].left;
+        slots[used++] = nodes[expanded].right;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        MeshBVHNode& n = nodes_[out];
+        if (i >= used) {
+            n.minX[i] = n.minY[i] = n.minZ[i] = FLT_MAX;
+            n.maxX[i] = n.maxY[i] = n.maxZ[i] = -FLT_MAX;
+            n.child[i] = -1;
+            n.count[i] = 0;
+            continue;
+        }
+        const BuildNode& c = nodes[slots[i]];
+        n.minX[i] = c.bounds.mn.x; n.minY[i] = c.bounds.mn.y; n.minZ[i] = c.bounds.mn.z;
+        n.maxX[i] = c.bounds.mx.x; n.maxY[i] = c.bounds.mx.y; n.maxZ[i] = c.bounds.mx.z;
+        if (c.left < 0) {
+            n.child[i] = (int32_t)c.first;
+            n.count[i] = c.count;
+        } else {
+            const int32_t child = (int32_t)nodes_.size();
+            nodes_.emplace_back();          // n может стать недействительной
+            nodes_[out].child[i] = child;
+            nodes_[out].count[i] = 0;
+            collapse(nodes, slots[i], child, depth + 1);
+        }
+    }
+}
+
+inline void MeshBVH::build(const cmesh4::SimpleMesh& mesh, const std::vector<Voxel>& materials) {
+    *this = MeshBVH();
+    materials_ = materials.empty() ? std::vector<Voxel>{VoxelMaterials::createStone()} : materials;
+    const int triangleCount = (int)mesh.TrianglesNum();
+    if (triangleCount == 0) return;
+
+    BuildContext ctx;
+    ctx.primBounds.resize(triangleCount);
+    ctx.centroids.resize(triangleCount);
+    ctx.prims.resize(triangleCount);
+    #pragma omp parallel for
+    for (int t = 0; t < triangleCount; t++) {
+        AABB box;
+        for (int k = 0; k < 3; k++) box.grow(LiteMath::to_float3(mesh.vPos4f[mesh.indices[3 * t + k]]));
+        ctx.primBounds[t] = box;
+        ctx.centroids[t] = (box.mn + box.mx) * 0.5f;
+        ctx.prims[t] = (uint32_t)t;
+    }
+
+    std::vector<BuildNode> nodes(1);
+    nodes[0].first = 0;
+    nodes[0].count = (uint32_t)triangleCount;
+    for (const AABB& b : ctx.primBounds) nodes[0].bounds.grow(b);
+
+    // Верх дерева: узлы по очереди, разбиение по корзинам параллельно
+    std::vector<int32_t> pending = {0}, subtrees;
+    while (!pending.empty()) {
+        const int32_t node = pending.back();
+        pending.pop_back();
+        if (nodes[node].count <= (uint32_t)MESH_BVH_PARALLEL_PRIMS) {
+            subtrees.push_back(node);
+        } else if (splitNode(ctx, nodes, node, true)) {
+            pending.push_back(nodes[node].right);
+            pending.push_back(nodes[node].left);
+        }
+    }
+
+    // Низ: поддеревья строятся независимо в свои массивы и затем пришиваются
+    std::vector<std::vector<BuildNode>> local(subtrees.size());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int s = 0; s < (int)subtrees.size(); s++) {
+        local[s].push_back(nodes[subtrees[s]]);
+        buildSubtree(ctx, local[s], 0);
+    }
+    for (size_t s = 0; s < subtrees.size(); s++) {
+        const int32_t base = (int32_t)nodes.size() - 1;   // local[s][0] заменяет сам узел
+        for (size_t i = 1; i < local[s].size(); i++) {
+            BuildNode n = local[s][i];
+            if (n.left >= 0) { n.left += base; n.right += base; }
+            nodes.push_back(n);
+        }
+        BuildNode root = local[s][0];
+        if (root.left >= 0) { root.left += base; root.right += base; }
+        nodes[subtrees[s]] = root;
+    }
+
+    // Треугольники в порядке листьев
+    triV0_.resize(triangleCount);
+    triE1_.resize(triangleCount);
+    triE2_.resize(triangleCount);
+    triMaterial_.resize(triangleCount);
+    triIndex_ = ctx.prims;
+    const bool hasNormals = mesh.vNorm4f.size() == mesh.vPos4f.size();
+    if (hasNormals) triNormals_.resize(3 * (size_t)triangleCount);
+    #pragma omp parallel for
+    for (int i = 0; i < triangleCount; i++) {
+        const uint32_t t = ctx.prims[i];
+        const float3 v0 = LiteMath::to_float3(mesh.vPos4f[mesh.indices[3 * t + 0]]);
+        const float3 v1 = LiteMath::to_float3(mesh.vPos4f[mesh.indices[3 * t + 1]]);
+        const float3 v2 = LiteMath::to_float3(mesh.vPos4f[mesh.indices[3 * t + 2]]);
+        triV0_[i] = v0;
+        triE1_[i] = v1 - v0;
+        triE2_[i] = v2 - v0;
+        const uint32_t material = t < mesh.matIndices.size() ? mesh.matIndices[t] : 0;
+        triMaterial_[i] = material < materials_.size() ? material : 0;
+        if (hasNormals) {
+            for (int k = 0; k < 3; k++) triNormals_[3 * (size_t)i + k] = LiteMath::to_float3(mesh.vNorm4f[mesh.indices[3 * t + k]]);
+        }
+    }
+    boundsMin_ = nodes[0].bounds.mn;
+    boundsMax_ = nodes[0].bounds.mx;
+
+    // Корень-лист (мало треугольников) оборачиваем во внутренний узел с одним потомком
+    if (nodes[0].left < 0) {
+        nodes_.resize(1);
+        MeshBVHNode& n = nodes_[0];
+        for (int i = 0; i < 4; i++) {
+            n.minX[i] = n.minY[i] = n.minZ[i] = FLT_MAX;
+            n.maxX[i] = n.maxY[i] = n.maxZ[i] = -FLT_MAX;
+            n.child[i] = -1;
+            n.count[i] = 0;
+        }
+        n.minX[0] = boundsMin_.x; n.minY[0] = boundsMin_.y; n.minZ[0] = boundsMin_.z;
+        n.maxX[0] = boundsMax_.x; n.maxY[0] = boundsMax_.y; n.maxZ[0] = boundsMax_.z;
+        n.child[0] = 0;
+        n.count[0] = nodes[0].count;
+        depth_ = 1;
+        return;
+    }
+    nodes_.reserve(nodes.size() / 2 + 1);
+    nodes_.emplace_back();
+    collapse(nodes, 0, 0, 1);
+}
+
+// ---------- трассировка ----------
+
+inline bool MeshBVH::intersect(const float3& origin, const float3& dir, float tMax, MeshHit& hit) const {
+    if (nodes_.empty()) return false;
+
+    // Нулевые компоненты направления заменяются малыми, чтобы в слэб-тесте не было 0 * inf
+    auto safeInv = [](float d) { return 1.0f / (fabsf(d) > 1e-20f ? d : (d < 0.0f ? -1e-20f : 1e-20f)); };
+    const float3 invDir(safeInv(dir.x), safeInv(dir.y), safeInv(dir.z));
+    int32_t bestTri = -1;
+    float bestU = 0.0f, bestV = 0.0f;
+
+    // Стек по глубине дерева: вырожденное дерево глубже MESH_BVH_STACK не теряет поддеревья
+    struct Entry { int32_t node; float t; };
+    Entry localStack[MESH_BVH_STACK];
+    std::vector<Entry> heapStack;
+    Entry* stack = localStack;
+    if (stackSize() > (size_t)MESH_BVH_STACK) { heapStack.resize(stackSize()); stack = heapStack.data(); }
+    int sp = 0;
+    stack[sp++] = {0, 0.0f};
+
+    while (sp > 0) {
+        const Entry e = stack[--sp];
+        if (e.t > tMax) continue;
+        const MeshBVHNode& n = nodes_[e.node];
+
+        // Слэб-тест с четырьмя коробками сразу
+        float tNear[4];
+        bool  any[4];
+        for (int i = 0; i < 4; i++) {
+            const float tx0 = (n.minX[i] - origin.x) * invDir.x, tx1 = (n.maxX[i] - origin.x) * invDir.x;
+            const float ty0 = (n.minY[i] - origin.y) * invDir.y, ty1 = (n.maxY[i] - origin.y) * invDir.y;
+            const float tz0 = (n.minZ[i] - origin.z) * invDir.z, tz1 = (n.maxZ[i] - origin.z) * invDir.z;
+            const float t0 = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+            const float t1 = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), tMax));
+            tNear[i] = t0;
+            any[i] = t0 <= t1 && n.child[i] >= 0;
+        }
+
+        // Попавшие потомки по убыванию tNear
+        int order[4], hits = 0;
+        for (int i = 0; i < 4; i++) {
+            if (!any[i]) continue;
+            int j = hits++;
+            while (j > 0 && tNear[order[j - 1]] < tNear[i]) { order[j] = order[j - 1]; j--; }
+            order[j] = i;
+        }
+
+        // Листья - сразу, от ближнего к дальнему (пересечение Моллера-Трумбора)
+        for (int k = hits - 1; k >= 0; k--) {
+            const int i = order[k];
+            if (n.count[i] == 0 || tNear[i] > tMax) continue;
+            for (uint32_t t = (uint32_t)n.child[i], tEnd = t + n.count[i]; t < tEnd; t++) {
+                const float3 p = LiteMath::cross(dir, triE2_[t]);
+                const float det = LiteMath::dot(triE1_[t], p);
+                if (fabsf(det) < 1e-12f) continue;
+                const float invDet = 1.0f / det;
+                const float3 s = origin - triV0_[t];
+                const float u = LiteMath::dot(s, p) * invDet;
+                if (u < 0.0f || u > 1.0f) continue;
+                const float3 q = LiteMath::cross(s, triE1_[t]);
+                const float v = LiteMath::dot(dir, q) * invDet;
+                if (v < 0.0f || u + v > 1.0f) continue;
+                const float tHit = LiteMath::dot(triE2_[t], q) * invDet;
+                if (tHit <= 0.0f || tHit >= tMax) continue;
+                tMax = tHit;
+                bestTri = (int32_t)t;
+                bestU = u;
+                bestV = v;
+            }
+        }
+
+        // Внутренние узлы - в стек, дальние первыми, чтобы ближний снимался следующим
+        for (int k = 0; k < hits; k++) {
+            const int i = order[k];
+            if (n.count[i] == 0 && tNear[i] <= tMax) stack[sp++] = {n.child[i], tNear[i]};
+        }
+    }
+    if (bestTri < 0) return false;
+
+    float3 normal = LiteMath::cross(triE1_[bestTri], triE2_[bestTri]);
+    if (!triNormals_.empty()) {
+        const float3 shading = triNormals_[3 * bestTri + 0] * (1.0f - bestU - bestV) +
+                               triNormals_[3 * bestTri + 1] * bestU + triNormals_[3 * bestTri + 2] * bestV;
+        if (LiteMath::dot(shading, shading) > 1e-12f) normal = shading;
+    }
+    normal = LiteMath::normalize(normal);
+    if (LiteMath::dot(normal, dir) > 0.0f) normal = -normal;
+
+    hit.t = tMax;
+    hit.normal = normal;
+    hit.voxel = materials_[triMaterial_[bestTri]];
+    hit.triangle = triIndex_[bestTri];
+    return true;
+}
+
+inline bool MeshBVH::occluded(const float3& origin, const float3& dir, float tMax) const {
+    if (nodes_.empty()) return false;
+
+    auto safeInv = [](float d) { return 1.0f / (fabsf(d) > 1e-20f ? d : (d < 0.0f ? -1e-20f : 1e-20f)); };
+    const float3 invDir(safeInv(dir.x), safeInv(dir.y), safeInv(dir.z));
+
+    int32_t localStack[MESH_BVH_STACK];
+    std::vector<int32_t> heapStack;
+    int32_t* stack = localStack;
+    if (stackSize() > (size_t)MESH_BVH_STACK) { heapStack.resize(stackSize()); stack = heapStack.data(); }
+    int sp = 0;
+    stack[sp++] = 0;
+
+    // Порядок обхода не важен: первое же попадание - ответ
+    while (sp > 0) {
+        const MeshBVHNode& n = nodes_[stack[--sp]];
+        for (int i = 0; i < 4; i++) {
+            if (n.child[i] < 0) continue;
+            const float tx0 = (n.minX[i] - origin.x) * invDir.x, tx1 = (n.maxX[i] - origin.x) * invDir.x;
+            const float ty0 = (n.minY[i] - origin.y) * invDir.y, ty1 = (n.maxY[i] - origin.y) * invDir.y;
+            const float tz0 = (n.minZ[i] - origin.z) * invDir.z, tz1 = (n.maxZ[i] - origin.z) * invDir.z;
+            const float t0 = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+            const float t1 = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), tMax));
+            if (t0 > t1) continue;
+
+            if (n.count[i] == 0) {
+                stack[sp++] = n.child[i];
+                continue;
+            }
+            for (uint32_t t = (uint32_t)n.child[i], tEnd = t + n.count[i]; t < tEnd; t++) {
+                const float3 p = LiteMath::cross(dir, triE2_[t]);
+                const float det = LiteMath::dot(triE1_[t], p);
+                if (fabsf(det) < 1e-12f) continue;
+                const float invDet = 1.0f / det;
+                const float3 s = origin - triV0_[t];
+                const float u = LiteMath::dot(s, p) * invDet;
+                if (u < 0.0f || u > 1.0f) continue;
+                const float3 q = LiteMath::cross(s, triE1_[t]);
+                const float v = LiteMath::dot(dir, q) * invDet;
+                if (v < 0.0f || u + v > 1.0f) continue;
+                const float tHit = LiteMath::dot(triE2_[t], q) * invDet;
+                if (tHit > 0.0f && tHit < tMax) return true;
+            }
+        }
+    }
+    return false;
+}
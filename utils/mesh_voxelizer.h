@@ -0,0 +1,190 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/mesh.h"
+#include "utils/voxel_world.h"
+#include "utils/voxel_mesher.h"
+
+#include <omp.h>
+#include <cstdint>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using LiteMath::float3;
+using LiteMath::int3;
+
+// ============ ВОКСЕЛИЗАЦИЯ ТРЕУГОЛЬНЫХ МЕШЕЙ ============
+// Консервативная вокселизация: заполняется каждая клетка, которую задевает
+// треугольник (тест пересечения треугольника и AABB по разделяющим осям,
+// Akenine-Moller). Клетка (i, j, k) сетки покрывает в координатах меша
+// origin + voxelSize * [i, i + 1) x [j, j + 1) x [k, k + 1).
+//
+// Треугольники раздаются потокам пачками по VOXELIZE_TRIANGLE_BATCH. Каждый
+// поток пишет найденные клетки в свои корзины по чанкам VOXEL_CHUNK_SIZE^3, а
+// затем чанки сливаются параллельно. Если клетку задели несколько треугольников,
+// побеждает треугольник с большим индексом, так что результат не зависит ни от
+// числа потоков, ни от порядка раздачи пачек.
+static constexpr int VOXELIZE_TRIANGLE_BATCH = 256;
+
+// Тест пересечения треугольника (v0, v1, v2) с AABB center +- halfSize.
+// Касание считается пересечением.
+inline bool triangleBoxOverlap(const float3& center, const float3& halfSize,
+                               float3 v0, float3 v1, float3 v2) {
+    v0 -= center; v1 -= center; v2 -= center;
+    const float3 e[3] = { v1 - v0, v2 - v1, v0 - v2 };
+
+    // 9 осей: векторные произведения ребер треугольника на оси AABB
+    for (int i = 0; i < 3; i++) {
+        for (int a = 0; a < 3; a++) {
+            float3 axis(0.0f);
+            axis[(a + 1) % 3] = -e[i][(a + 2) % 3];
+            axis[(a + 2) % 3] =  e[i][(a + 1) % 3];
+            const float p0 = LiteMath::dot(v0, axis);
+            const float p1 = LiteMath::dot(v1, axis);
+            const float p2 = LiteMath::dot(v2, axis);
+            const float r = halfSize[(a + 1) % 3] * fabsf(axis[(a + 1) % 3]) +
+                            halfSize[(a + 2) % 3] * fabsf(axis[(a + 2) % 3]);
+            if (std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r) return false;
+        }
+    }
+
+    // 3 оси AABB
+    for (int a = 0; a < 3; a++) {
+        if (std::min(v0[a], std::min(v1[a], v2[a])) >  halfSize[a] ||
+            std::max(v0[a], std::max(v1[a], v2[a])) < -halfSize[a]) return false;
+    }
+
+    // Плоскость треугольника
+    const float3 normal = LiteMath::cross(e[0], e[1]);
+    const float r = halfSize.x * fabsf(normal.x) + halfSize.y * fabsf(normal.y) + halfSize.z * fabsf(normal.z);
+    return fabsf(LiteMath::dot(normal, v0)) <= r;
+}
+
+// Воксель для материала меша. По умолчанию индексы материалов совпадают с типами
+// вокселей (так их пишет exportVoxelWorldObj) и ищутся в таблице материалов;
+// воздух (0 - индекс OBJ без материалов) и материалы, которых нет в таблице,
+// становятся камнем.
+inline Voxel voxelForMaterial(uint32_t material, const std::vector<Voxel>& palette) {
+    if (material < palette.size()) return palette[material];
+    if (material == VoxelMaterials::AIR || material >= (uint32_t)MaterialTable::MAX_MATERIALS ||
+        materialTable().name((uint8_t)material).empty())
+        return VoxelMaterials::createStone();
+    if (material == VoxelMaterials::WATER) return VoxelMaterials::createWater(); // с плотностью
+    return VoxelMaterials::createVoxel((uint8_t)material);
+}
+
+// Размер вокселя, при котором наибольшая сторона AABB меша занимает resolution клеток
+inline float voxelSizeForResolution(const cmesh4::SimpleMesh& mesh, int resolution,
+                                    float3& boundsMin, float3& boundsMax) {
+    boundsMin = float3(FLT_MAX);
+    boundsMax = float3(-FLT_MAX);
+    for (const auto& p : mesh.vPos4f) {
+        boundsMin = LiteMath::min(boundsMin, LiteMath::to_float3(p));
+        boundsMax = LiteMath::max(boundsMax, LiteMath::to_float3(p));
+    }
+    const float3 extent = boundsMax - boundsMin;
+    return std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f)) / (float)resolution;
+}
+
+// Записывает треугольники меша в world. Возвращает число заполненных клеток.
+inline size_t voxelizeMesh(const cmesh4::SimpleMesh& mesh, GridVoxelWorld& world,
+                           const float3& origin, float voxelSize,
+                           const std::vector<Voxel>& palette = {}) {
+    struct CellWrite {
+        uint32_t cell;          // индекс клетки внутри чанка
+        uint32_t triangle;
+    };
+
+    const int3 size(world.getSizeX(), world.getSizeY(), world.getSizeZ());
+    const int3 chunks((size.x + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE,
+                      (size.y + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE,
+                      (size.z + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE);
+    const int chunkCount = chunks.x * chunks.y * chunks.z;
+    const int triangleCount = (int)mesh.TrianglesNum();
+    const int batchCount = (triangleCount + VOXELIZE_TRIANGLE_BATCH - 1) / VOXELIZE_TRIANGLE_BATCH;
+    const float invVoxelSize = 1.0f / voxelSize;
+    const float3 halfSize(0.5f);
+
+    std::vector<std::vector<std::vector<CellWrite>>> bins(omp_get_max_threads()); // [поток][чанк]
+
+    #pragma omp parallel
+    {
+        std::vector<std::vector<CellWrite>>& threadBins = bins[omp_get_thread_num()];
+        threadBins.resize(chunkCount);
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int batch = 0; batch < batchCount; batch++) {
+            const int tEnd = std::min(triangleCount, (batch + 1) * VOXELIZE_TRIANGLE_BATCH);
+            for (int t = batch * VOXELIZE_TRIANGLE_BATCH; t < tEnd; t++) {
+                // Вершины в координатах сетки: клетка (i, j, k) - это [i, i + 1)^3
+                float3 v[3];
+                for (int k = 0; k < 3; k++)
+                    v[k] = (LiteMath::to_float3(mesh.vPos4f[mesh.indices[t * 3 + k]]) - origin) * invVoxelSize;
+
+                const float3 mn = LiteMath::min(v[0], LiteMath::min(v[1], v[2]));
+                const float3 mx = LiteMath::max(v[0], LiteMath::max(v[1], v[2]));
+                // ceil - 1: треугольник, лежащий ровно на границе клеток, задевает обе
+                const int3 lo(std::max(0, (int)ceilf(mn.x) - 1), std::max(0, (int)ceilf(mn.y) - 1),
+                              std::max(0, (int)ceilf(mn.z) - 1));
+                const int3 hi(std::min(size.x - 1, (int)floorf(mx.x)), std::min(size.y - 1, (int)floorf(mx.y)),
+                              std::min(size.z - 1, (int)floorf(mx.z)));
+
+                for (int x = lo.x; x <= hi.x; x++)
+                for (int y = lo.y; y <= hi.y; y++)
+                for (int z = lo.z; z <= hi.z; z++) {
+                    const float3 center((float)x + 0.5f, (float)y + 0.5f, (float)z + 0.5f);
+                    if (!triangleBoxOverlap(center, halfSize, v[0], v[1], v[2])) continue;
+                    const int chunk = ((x / VOXEL_CHUNK_SIZE) * chunks.y + y / VOXEL_CHUNK_SIZE) * chunks.z + z / VOXEL_CHUNK_SIZE;
+                    const uint32_t cell = ((x % VOXEL_CHUNK_SIZE) * VOXEL_CHUNK_SIZE + y % VOXEL_CHUNK_SIZE) * VOXEL_CHUNK_SIZE
+                                        + z % VOXEL_CHUNK_SIZE;
+                    threadBins[chunk].push_back({cell, (uint32_t)t});
+                }
+            }
+        }
+    }
+
+    size_t filled = 0;
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:filled)
+    for (int chunk = 0; chunk < chunkCount; chunk++) {
+        std::vector<int> winner(VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE, -1);
+        bool any = false;
+        for (const auto& threadBins : bins) {
+            if (threadBins.empty()) continue;
+            for (const CellWrite& w : threadBins[chunk]) {
+                winner[w.cell] = std::max(winner[w.cell], (int)w.triangle);
+                any = true;
+            }
+        }
+        if (!any) continue;
+
+        const int cx = chunk / (chunks.y * chunks.z);
+        const int cy = (chunk / chunks.z) % chunks.y;
+        const int cz = chunk % chunks.z;
+        for (int cell = 0; cell < (int)winner.size(); cell++) {
+            if (winner[cell] < 0) continue;
+            const int x = cx * VOXEL_CHUNK_SIZE + cell / (VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE);
+            const int y = cy * VOXEL_CHUNK_SIZE + (cell / VOXEL_CHUNK_SIZE) % VOXEL_CHUNK_SIZE;
+            const int z = cz * VOXEL_CHUNK_SIZE + cell % VOXEL_CHUNK_SIZE;
+            const uint32_t material = winner[cell] < (int)mesh.matIndices.size() ? mesh.matIndices[winner[cell]] : 0;
+            world.setVoxel(x, y, z, voxelForMaterial(material, palette));
+            filled++;
+        }
+    }
+    return filled;
+}
+
+// Загружает OBJ и вписывает его в область мира: наибольшая сторона модели
+// занимает resolution клеток, модель центрируется по x/z над клеткой base.
+inline size_t voxelizeObjIntoWorld(const char* fileName, GridVoxelWorld& world, int resolution, const int3& base,
+                                   const std::vector<Voxel>& palette = {}) {
+    cmesh4::SimpleMesh mesh = cmesh4::LoadMeshFromObjCached(fileName);
+    if (mesh.TrianglesNum() == 0) return 0;
+
+    float3 boundsMin, boundsMax;
+    const float voxelSize = voxelSizeForResolution(mesh, resolution, boundsMin, boundsMax);
+    const float3 extent = (boundsMax - boundsMin) / voxelSize;
+    const float3 cellOffset((float)base.x - 0.5f * extent.x, (float)base.y, (float)base.z - 0.5f * extent.z);
+    return voxelizeMesh(mesh, world, boundsMin - cellOffset * voxelSize, voxelSize, palette);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/public_camera.h"
+
+#include <cmath>
+
+using LiteMath::float3;
+
+// ============ ГЕНЕРАТОР ПЕРВИЧНЫХ ЛУЧЕЙ ============
+// Базис камеры и приращения на пиксель считаются один раз за кадр, после чего
+// направление через пиксель (x, y) - это dir00 + x*dx + y*dy, без умножения на
+// обратную матрицу и перспективного деления. Совпадает с лучами, полученными
+// через inverse4x4(proj * view) для lookAt/perspectiveMatrix из LiteMath.
+struct RayGenerator {
+    float3 origin;          // позиция камеры
+    float3 forward;         // направление взгляда (единичное)
+    float3 dir00;           // ненормированное направление через центр пикселя (0, 0)
+    float3 dx;              // приращение направления на один пиксель по x
+    float3 dy;              // приращение направления на один пиксель по y
+    int width  = 0;
+    int height = 0;
+
+    RayGenerator() = default;
+    
+    RayGenerator(const Camera& camera, int W, int H) : origin(camera.pos), width(W), height(H) {
+        // Тот же базис, что строит LiteMath::lookAt
+        float3 back    = LiteMath::normalize(camera.pos - camera.target);
+        float3 right   = LiteMath::normalize(LiteMath::cross(camera.up, back));
+        float3 up      = LiteMath::normalize(LiteMath::cross(back, right));
+        
+        const float tanHalfY = tanf(camera.fov_rad * 0.5f);
+        const float tanHalfX = tanHalfY * (float)W / (float)H;
+        
+        // ndc_x = 2*(x+0.5)/W - 1, ndc_y = 1 - 2*(y+0.5)/H
+        forward = -back;
+        dx    = right * (2.0f * tanHalfX / W);
+        dy    = up * (-2.0f * tanHalfY / H);
+        dir00 = forward + right * (tanHalfX * (1.0f / W - 1.0f)) + up * (tanHalfY * (1.0f - 1.0f / H));
+    }
+    
+    // Ненормированное направление через точку (px, py) в пикселях
+    float3 directionAt(float px, float py) const {
+        return dir00 + dx * (px - 0.5f) + dy * (py - 0.5f);
+    }
+    
+    // Нормированное направление через центр пикселя (x, y)
+    float3 pixelDirection(int x, int y) const {
+        return LiteMath::normalize(dir00 + dx * (float)x + dy * (float)y);
+    }
+    
+    // Обратная операция к directionAt: проекция точки p в пиксельные координаты.
+    // depth - расстояние вдоль forward; false, если точка позади камеры.
+    bool project(const float3& p, float& px, float& py, float& depth) const {
+        float3 v = p - origin;
+        depth = LiteMath::dot(v, forward);
+        if (depth <= 1e-4f) return false;
+        // У dir00 + dx*a + dy*b компонента вдоль forward равна 1, а dx и dy ортогональны
+        float3 offset = v / depth - dir00;
+        px = LiteMath::dot(offset, dx) / LiteMath::dot(dx, dx) + 0.5f;
+        py = LiteMath::dot(offset, dy) / LiteMath::dot(dy, dy) + 0.5f;
+        return true;
+    }
+    
+    // Направления для пикселей [x0, x0 + count) строки y в SoA-буферы.
+    // Оба цикла без ветвлений по простым массивам float и векторизуются компилятором,
+    // так что нормализация идет пачками по 4/8 лучей.
+    void generateRow(int y, int x0, int count, float* dirX, float* dirY, float* dirZ) const {
+        const float3 rowStart = dir00 + dy * (float)y + dx * (float)x0;
+        for (int i = 0; i < count; i++) {
+            dirX[i] = rowStart.x + dx.x * (float)i;
+            dirY[i] = rowStart.y + dx.y * (float)i;
+            dirZ[i] = rowStart.z + dx.z * (float)i;
+        }
+        for (int i = 0; i < count; i++) {
+            float invLen = 1.0f / sqrtf(dirX[i] * dirX[i] + dirY[i] * dirY[i] + dirZ[i] * dirZ[i]);
+            dirX[i] *= invLen;
+            dirY[i] *= invLen;
+            dirZ[i] *= invLen;
+        }
+    }
+};
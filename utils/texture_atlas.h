@@ -0,0 +1,438 @@
+#pragma once
+
+// Реализация stb_image не защищена от повторного включения, поэтому заголовок
+// подключается, только если его еще нет (main.cpp берет его через public_image.h)
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include "utils/stb_image.h"
+#endif
+
+#include <omp.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Файл, отображенный в память только для чтения (без mmap - прочитанный целиком)
+class MappedFileView {
+public:
+    MappedFileView() = default;
+    MappedFileView(const MappedFileView&) = delete;
+    MappedFileView& operator=(const MappedFileView&) = delete;
+    ~MappedFileView() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+#if !defined(_WIN32)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        const off_t size = lseek(fd, 0, SEEK_END);
+        if (size > 0) {
+            void* data = mmap(nullptr, (size_t)size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = static_cast<const uint8_t*>(data);
+                size_ = (size_t)size;
+                mapped_ = true;
+            }
+        }
+        ::close(fd);
+        return data_ != nullptr;
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        buffer_.resize((size_t)in.tellg());
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size());
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        return size_ > 0;
+#endif
+    }
+
+    void close() {
+#if !defined(_WIN32)
+        if (mapped_) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+        buffer_.clear();
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+    }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> buffer_;
+};
+
+// ============ АТЛАС ТЕКСТУР БЛОКОВ ============
+// Все текстуры лежат в одном массиве ARGB8 (тот же формат, что и кадр) в виде
+// сетки тайлов tileSize x tileSize. Уровни мипов хранятся подряд: на уровне L
+// тайл занимает (tileSize >> L)^2 текселей на том же месте сетки, так что
+// уменьшение 2x2 никогда не смешивает соседние текстуры. Адресация внутри
+// тайла с повтором (repeat), билинейная фильтрация тоже не выходит за тайл.
+//
+// Декодирование PNG идет параллельно (OpenMP). Готовый атлас с мипами можно
+// сохранить в кэш-файл, ключ которого - хэш имен и содержимого всех PNG:
+// при следующем запуске кэш отображается в память, и тексели используются
+// на месте без декодирования (см. loadDirectoryCached).
+static constexpr uint32_t TEXTURE_CACHE_VERSION = 1;
+
+struct TextureCacheHeader {
+    char     magic[8];          // "VOXATL1\0"
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t key;               // хэш исходных PNG
+    int32_t  tileSize, cols, rows, levels;
+    uint32_t textureCount;
+    uint32_t namesSize;         // имена через '\0' сразу после заголовка
+    uint64_t texelsOffset;      // выровнено на 64
+    uint64_t texelCount;
+    uint64_t fileSize;
+    uint64_t checksum;          // по всему, что после заголовка
+};
+
+// FNV-1a, 64 бита
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t h = 0xcbf29ce484222325ULL) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) h = (h ^ p[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+class TextureAtlas {
+public:
+    static constexpr int MAX_LEVELS = 8;
+
+    TextureAtlas() = default;
+    TextureAtlas(TextureAtlas&&) = default;
+    TextureAtlas& operator=(TextureAtlas&&) = default;
+    TextureAtlas(const TextureAtlas&) = delete;            // texels_ может указывать в свой же storage_
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    // Добавляет текстуру из RGBA8 (stb: r, g, b, a по байтам). Текстура другого
+    // размера приводится к tileSize ближайшим текселем. Возвращает индекс.
+    int addImage(const std::string& name, const uint8_t* rgba, int width, int height) {
+        if (tileSize_ == 0) {
+            // Размер тайла - степень двойки (адресация с повтором через маску)
+            tileSize_ = 1;
+            while (tileSize_ * 2 <= std::max(width, height)) tileSize_ *= 2;
+        }
+        std::vector<uint32_t> tile(tileSize_ * tileSize_);
+        for (int y = 0; y < tileSize_; y++) {
+            for (int x = 0; x < tileSize_; x++) {
+                const uint8_t* p = rgba + 4 * ((y * height / tileSize_) * width + x * width / tileSize_);
+                tile[y * tileSize_ + x] = ((uint32_t)p[3] << 24) | ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+            }
+        }
+        names_.push_back(name);
+        pending_.push_back(std::move(tile));
+        return (int)names_.size() - 1;
+    }
+
+    // Загружает файл через stb_image. -1, если файл не читается.
+    int loadImage(const std::string& path, const std::string& name) {
+        int width = 0, height = 0, channels = 0;
+        uint8_t* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (!data) return -1;
+        const int index = addImage(name, data, width, height);
+        stbi_image_free(data);
+        return index;
+    }
+
+    // Все *.png каталога в порядке имен; имя текстуры - имя файла без расширения.
+    // Файлы декодируются параллельно, затем собираются атлас и мипы.
+    // Возвращает число текстур.
+    int loadDirectory(const std::string& dir) {
+        std::vector<std::filesystem::path> files = listImages(dir);
+        std::vector<std::vector<uint8_t>> encoded(files.size());
+        for (size_t i = 0; i < files.size(); i++) readFile(files[i].string(), encoded[i]);
+        decodeAll(files, encoded);
+        build();
+        return textureCount();
+    }
+
+    // То же, но с кэшем декодированного атласа в cachePath. Ключ кэша - хэш
+    // имен и содержимого PNG: чтение файлов намного дешевле декодирования.
+    // Если ключ совпал, атлас берется из отображенного в память кэша, иначе
+    // PNG декодируются и кэш переписывается.
+    int loadDirectoryCached(const std::string& dir, const std::string& cachePath) {
+        std::vector<std::filesystem::path> files = listImages(dir);
+        std::vector<std::vector<uint8_t>> encoded(files.size());
+        uint64_t key = hashBytes(&TEXTURE_CACHE_VERSION, sizeof(TEXTURE_CACHE_VERSION));
+        for (size_t i = 0; i < files.size(); i++) {
+            readFile(files[i].string(), encoded[i]);
+            const std::string name = files[i].stem().string();
+            key = hashBytes(name.c_str(), name.size() + 1, key);
+            key = hashBytes(encoded[i].data(), encoded[i].size(), key);
+        }
+        if (files.empty()) return 0;
+
+        if (openCache(cachePath, key)) return textureCount();
+        decodeAll(files, encoded);
+        build();
+        saveCache(cachePath, key);
+        return textureCount();
+    }
+
+    bool fromCache() const { return mapping_ != nullptr; }
+
+    // Раскладывает добавленные текстуры в сетку и считает мипы (среднее 2x2 с округлением)
+    void build() {
+        const int count = (int)pending_.size();
+        if (count == 0) return;
+        cols_ = (int)ceilf(sqrtf((float)count));
+        rows_ = (count + cols_ - 1) / cols_;
+        levels_ = 1;
+        while (levels_ < MAX_LEVELS && (tileSize_ >> levels_) > 0) levels_++;
+
+        size_t offset = 0;
+        for (int level = 0; level < levels_; level++) {
+            const int tile = tileSize_ >> level;
+            levelOffset_[level] = offset;
+            levelWidth_[level] = cols_ * tile;
+            offset += (size_t)cols_ * tile * rows_ * tile;
+        }
+        mapping_.reset();
+        storage_.assign(offset, 0);
+
+        for (int t = 0; t < count; t++) {
+            const int ox = (t % cols_) * tileSize_, oy = (t / cols_) * tileSize_;
+            for (int y = 0; y < tileSize_; y++)
+                std::copy_n(&pending_[t][y * tileSize_], tileSize_, &storage_[(oy + y) * levelWidth_[0] + ox]);
+        }
+        for (int level = 1; level < levels_; level++) {
+            const uint32_t* src = &storage_[levelOffset_[level - 1]];
+            uint32_t* dst = &storage_[levelOffset_[level]];
+            const int srcW = levelWidth_[level - 1], dstW = levelWidth_[level];
+            const int dstH = rows_ * (tileSize_ >> level);
+            for (int y = 0; y < dstH; y++) {
+                for (int x = 0; x < dstW; x++) {
+                    const uint32_t c[4] = { src[(2 * y) * srcW + 2 * x], src[(2 * y) * srcW + 2 * x + 1],
+                                            src[(2 * y + 1) * srcW + 2 * x], src[(2 * y + 1) * srcW + 2 * x + 1] };
+                    uint32_t result = 0;
+                    for (int shift = 0; shift < 32; shift += 8) {
+                        uint32_t sum = 2;
+                        for (uint32_t v : c) sum += (v >> shift) & 0xFF;
+                        result |= (sum >> 2) << shift;
+                    }
+                    dst[y * dstW + x] = result;
+                }
+            }
+        }
+        pending_.clear();
+        pending_.shrink_to_fit();
+        texels_ = storage_.data();
+        texelCount_ = storage_.size();
+    }
+
+    int find(const std::string& name) const {
+        for (size_t i = 0; i < names_.size(); i++) {
+            if (names_[i] == name) return (int)i;
+        }
+        return -1;
+    }
+
+    int  textureCount() const { return texelCount_ == 0 ? 0 : (int)names_.size(); }
+    int  tileSize()     const { return tileSize_; }
+    int  levels()       const { return levels_; }
+    bool empty()        const { return texelCount_ == 0; }
+    size_t getMemoryUsage() const { return texelCount_ * sizeof(uint32_t); }
+
+    // Тексель (x, y) текстуры texture на уровне level, координаты с повтором
+    uint32_t fetch(int texture, int x, int y, int level) const {
+        const int tile = tileSize_ >> level;
+        const int ox = (texture % cols_) * tile, oy = (texture / cols_) * tile;
+        return texels_[levelOffset_[level] + (size_t)(oy + (y & (tile - 1))) * levelWidth_[level] + ox + (x & (tile - 1))];
+    }
+
+    // Билинейная выборка, u, v в долях текстуры (с повтором). Веса 8-битные,
+    // каналы считаются парами в одном 32-битном слове (R|B и A|G).
+    uint32_t sample(int texture, float u, float v, int level) const {
+        const int tile = tileSize_ >> level;
+        const float fx = u * tile - 0.5f, fy = v * tile - 0.5f;
+        const float flx = floorf(fx), fly = floorf(fy);
+        const int x = (int)flx, y = (int)fly;
+        const uint32_t wx = (uint32_t)((fx - flx) * 256.0f), wy = (uint32_t)((fy - fly) * 256.0f);
+        return bilerp(fetch(texture, x, y, level), fetch(texture, x + 1, y, level),
+                      fetch(texture, x, y + 1, level), fetch(texture, x + 1, y + 1, level), wx, wy);
+    }
+
+    // Смесь четырех ARGB8 цветов с весами wx, wy в 0..256 (SWAR по два канала)
+    static uint32_t bilerp(uint32_t c00, uint32_t c01, uint32_t c10, uint32_t c11, uint32_t wx, uint32_t wy) {
+        auto lerp2 = [](uint32_t a, uint32_t b, uint32_t w) {   // a, b - по два 8-битных канала в 0x00FF00FF
+            return ((a * (256 - w) + b * w) >> 8) & 0x00FF00FFu;
+        };
+        const uint32_t rbTop = lerp2(c00 & 0x00FF00FFu, c01 & 0x00FF00FFu, wx);
+        const uint32_t rbBot = lerp2(c10 & 0x00FF00FFu, c11 & 0x00FF00FFu, wx);
+        const uint32_t agTop = lerp2((c00 >> 8) & 0x00FF00FFu, (c01 >> 8) & 0x00FF00FFu, wx);
+        const uint32_t agBot = lerp2((c10 >> 8) & 0x00FF00FFu, (c11 >> 8) & 0x00FF00FFu, wx);
+        return lerp2(rbTop, rbBot, wy) | (lerp2(agTop, agBot, wy) << 8);
+    }
+
+private:
+    int tileSize_ = 0;
+    int cols_ = 0, rows_ = 0, levels_ = 0;
+    size_t levelOffset_[MAX_LEVELS] = {};
+    int    levelWidth_[MAX_LEVELS] = {};
+    const uint32_t* texels_ = nullptr;   // storage_ или тексели в отображенном кэше
+    size_t texelCount_ = 0;
+    std::vector<uint32_t> storage_;
+    std::shared_ptr<MappedFileView> mapping_;
+    std::vector<std::string> names_;
+    std::vector<std::vector<uint32_t>> pending_;   // текстуры до build()
+
+    static std::vector<std::filesystem::path> listImages(const std::string& dir) {
+        std::vector<std::filesystem::path> files;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+            if (entry.path().extension() == ".png") files.push_back(entry.path());
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    static bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        bytes.resize((size_t)in.tellg());
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+        return (bool)in;
+    }
+
+    static uint64_t payloadChecksum(const uint8_t* data, size_t size) {
+        uint64_t h = 0x9E3779B97F4A7C15ULL;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t w;
+            memcpy(&w, data + i, 8);
+            h = (h ^ w) * 0x100000001b3ULL;
+            h ^= h >> 29;
+        }
+        return hashBytes(data + i, size - i, h);
+    }
+
+    // Параллельное декодирование; текстуры добавляются в порядке файлов
+    void decodeAll(const std::vector<std::filesystem::path>& files, const std::vector<std::vector<uint8_t>>& encoded) {
+        struct Decoded { uint8_t* rgba = nullptr; int width = 0, height = 0; };
+        std::vector<Decoded> decoded(files.size());
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int i = 0; i < (int)files.size(); i++) {
+            int channels = 0;
+            if (!encoded[i].empty()) {
+                decoded[i].rgba = stbi_load_from_memory(encoded[i].data(), (int)encoded[i].size(),
+                                                        &decoded[i].width, &decoded[i].height, &channels, 4);
+            }
+        }
+        for (size_t i = 0; i < files.size(); i++) {
+            if (!decoded[i].rgba) continue;
+            addImage(files[i].stem().string(), decoded[i].rgba, decoded[i].width, decoded[i].height);
+            stbi_image_free(decoded[i].rgba);
+        }
+    }
+
+    bool openCache(const std::string& path, uint64_t key) {
+        auto mapping = std::make_shared<MappedFileView>();
+        if (!mapping->open(path) || mapping->size() < sizeof(TextureCacheHeader)) return false;
+        TextureCacheHeader header;
+        memcpy(&header, mapping->data(), sizeof(header));
+        if (memcmp(header.magic, "VOXATL1", 8) != 0 || header.version != TEXTURE_CACHE_VERSION ||
+            header.headerSize != sizeof(TextureCacheHeader) || header.key != key ||
+            header.fileSize != mapping->size() || header.levels < 1 || header.levels > MAX_LEVELS ||
+            header.texelsOffset + header.texelCount * sizeof(uint32_t) > header.fileSize ||
+            sizeof(header) + header.namesSize > header.texelsOffset) return false;
+        if (payloadChecksum(mapping->data() + sizeof(header), mapping->size() - sizeof(header)) != header.checksum)
+            return false;
+
+        std::vector<std::string> names;
+        const char* p = reinterpret_cast<const char*>(mapping->data() + sizeof(header));
+        const char* end = p + header.namesSize;
+        while (p < end) {
+            names.emplace_back(p);
+            p += names.back().size() + 1;
+        }
+        if (names.size() != header.textureCount) return false;
+
+        *this = TextureAtlas();
+        tileSize_ = header.tileSize;
+        cols_ = header.cols;
+        rows_ = header.rows;
+        levels_ = header.levels;
+        size_t offset = 0;
+        for (int level = 0; level < levels_; level++) {
+            const int tile = tileSize_ >> level;
+            levelOffset_[level] = offset;
+            levelWidth_[level] = cols_ * tile;
+            offset += (size_t)cols_ * tile * rows_ * tile;
+        }
+        if (offset != header.texelCount) return false;
+        names_ = std::move(names);
+        texels_ = reinterpret_cast<const uint32_t*>(mapping->data() + header.texelsOffset);
+        texelCount_ = header.texelCount;
+        mapping_ = std::move(mapping);
+        return true;
+    }
+
+    // Пишет во временный файл и переименовывает: параллельно запущенные
+    // процессы никогда не увидят недописанный кэш
+    bool saveCache(const std::string& path, uint64_t key) const {
+        if (empty()) return false;
+        std::string names;
+        for (const std::string& name : names_) names.append(name.c_str(), name.size() + 1);
+
+        TextureCacheHeader header = {};
+        memcpy(header.magic, "VOXATL1", 8);
+        header.version = TEXTURE_CACHE_VERSION;
+        header.headerSize = sizeof(TextureCacheHeader);
+        header.key = key;
+        header.tileSize = tileSize_;
+        header.cols = cols_;
+        header.rows = rows_;
+        header.levels = levels_;
+        header.textureCount = (uint32_t)names_.size();
+        header.namesSize = (uint32_t)names.size();
+        header.texelsOffset = (sizeof(header) + names.size() + 63) / 64 * 64;
+        header.texelCount = texelCount_;
+        header.fileSize = header.texelsOffset + texelCount_ * sizeof(uint32_t);
+
+        std::vector<uint8_t> file(header.fileSize, 0);
+        memcpy(file.data() + sizeof(header), names.data(), names.size());
+        memcpy(file.data() + header.texelsOffset, texels_, texelCount_ * sizeof(uint32_t));
+        header.checksum = payloadChecksum(file.data() + sizeof(header), file.size() - sizeof(header));
+        memcpy(file.data(), &header, sizeof(header));
+
+#if !defined(_WIN32)
+        const std::string tmpPath = path + ".tmp" + std::to_string((long long)getpid());
+#else
+        const std::string tmpPath = path + ".tmp";
+#endif
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            out.write(reinterpret_cast<const char*>(file.data()), file.size());
+            if (!out) {
+                out.close();
+                std::remove(tmpPath.c_str());
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) std::remove(tmpPath.c_str());
+        return !ec;
+    }
+};
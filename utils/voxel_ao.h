@@ -0,0 +1,212 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/voxel_world.h"
+#include "utils/voxel_mesher.h"
+
+#include <omp.h>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using LiteMath::float3;
+using LiteMath::int3;
+
+// ============ ЗАПЕЧЕННОЕ ЗАТЕНЕНИЕ ГРАНЕЙ (AO) ============
+// Угловое AO по окрестности 3x3x3: для угла открытой грани смотрятся две
+// боковые клетки и диагональная в слое перед гранью,
+//   ao = (side1 && side2) ? 0 : 3 - (side1 + side2 + corner),
+// 3 - угол открыт, 0 - зажат. 2 бита на угол, байт на грань.
+//
+// Хранится по чанкам VOXEL_CHUNK_SIZE^3 (как у мешера): у чанка с открытыми
+// гранями есть таблица клетка -> слот, в слоте 6 байт граней вокселя.
+// Чанки без открытых граней ничего не хранят.
+//
+// Необязательный трассируемый член: из центра каждой открытой грани идут
+// AO_RAY_COUNT коротких any-hit лучей длины AO_RAY_DIST, доля открытых
+// умножает угловые значения перед квантованием в те же 2 бита.
+static constexpr int   AO_RAY_COUNT = 12;
+static constexpr float AO_RAY_DIST  = 4.0f;
+static constexpr float AO_MIN_LIGHT = 0.45f;  // освещенность полностью зажатого угла
+
+class VoxelAO {
+public:
+    static constexpr uint16_t NO_SLOT = 0xFFFF;
+
+    // Запекает AO всего мира, чанки считаются параллельно
+    template<class World>
+    void build(const World& world, bool rayTraced = false) {
+        sizeX = world.getSizeX();
+        sizeY = world.getSizeY();
+        sizeZ = world.getSizeZ();
+        nx = (sizeX + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE;
+        ny = (sizeY + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE;
+        nz = (sizeZ + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE;
+        rayTraced_ = rayTraced;
+        chunks.assign(nx * ny * nz, Chunk());
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int c = 0; c < (int)chunks.size(); c++) {
+            const int3 base = chunkOrigin(c);
+            for (int x = base.x; x < std::min(base.x + VOXEL_CHUNK_SIZE, sizeX); x++)
+            for (int y = base.y; y < std::min(base.y + VOXEL_CHUNK_SIZE, sizeY); y++)
+            for (int z = base.z; z < std::min(base.z + VOXEL_CHUNK_SIZE, sizeZ); z++)
+                bakeVoxel(world, x, y, z);
+        }
+    }
+
+    // Пересчет после изменения вокселя (x, y, z): угловое AO зависит только от
+    // соседей в пределах 1 клетки, трассируемое - в пределах длины луча.
+    // Воксель, закрытый правкой, сохраняет слот (все углы 0xFF), так что
+    // слотов в чанке не больше его клеток и повторные правки их не плодят.
+    template<class World>
+    void update(const World& world, int x, int y, int z) {
+        if (!built()) return;
+        const int r = rayTraced_ ? (int)ceilf(AO_RAY_DIST) + 1 : 1;
+        for (int vx = std::max(x - r, 0); vx <= std::min(x + r, sizeX - 1); vx++)
+        for (int vy = std::max(y - r, 0); vy <= std::min(y + r, sizeY - 1); vy++)
+        for (int vz = std::max(z - r, 0); vz <= std::min(z + r, sizeZ - 1); vz++)
+            bakeVoxel(world, vx, vy, vz);
+    }
+
+    bool built() const { return !chunks.empty(); }
+    bool rayTraced() const { return rayTraced_; }
+
+    // Байт грани face (порядок VOXEL_FACE_NORMALS) вокселя, 0xFF - все углы открыты
+    uint8_t faceCorners(int x, int y, int z, int face) const {
+        if (x < 0 || y < 0 || z < 0 || x >= sizeX || y >= sizeY || z >= sizeZ) return 0xFF;
+        const Chunk& chunk = chunks[chunkIndex(x, y, z)];
+        if (chunk.slot.empty()) return 0xFF;
+        const uint16_t slot = chunk.slot[cellIndex(x, y, z)];
+        return slot == NO_SLOT ? 0xFF : chunk.faces[slot * 6 + face];
+    }
+
+    // Множитель освещения в точке gridPos (координаты сетки) на грани вокселя voxel:
+    // грань - ближайшая к точке, значения углов интерполируются билинейно
+    float lightAt(const int3& voxel, const float3& gridPos) const {
+        const int face = nearestVoxelFace(voxel, gridPos);
+        const uint8_t corners = faceCorners(voxel.x, voxel.y, voxel.z, face);
+        if (corners == 0xFF) return 1.0f;
+
+        const int axis = face / 2;
+        const float3 local = gridPos - float3((float)voxel.x, (float)voxel.y, (float)voxel.z);
+        const float u = std::clamp(local[(axis + 1) % 3], 0.0f, 1.0f);
+        const float v = std::clamp(local[(axis + 2) % 3], 0.0f, 1.0f);
+        auto level = [&](int corner) { return (float)((corners >> (2 * corner)) & 3); };
+        const float ao = ((level(0) * (1.0f - u) + level(1) * u) * (1.0f - v) +
+                          (level(2) * (1.0f - u) + level(3) * u) * v) / 3.0f;
+        return AO_MIN_LIGHT + (1.0f - AO_MIN_LIGHT) * ao;
+    }
+
+    size_t getMemoryUsage() const {
+        size_t bytes = chunks.size() * sizeof(Chunk);
+        for (const Chunk& chunk : chunks)
+            bytes += chunk.slot.size() * sizeof(uint16_t) + chunk.faces.size();
+        return bytes;
+    }
+
+private:
+    struct Chunk {
+        std::vector<uint16_t> slot;    // клетка чанка -> слот, пусто - нет открытых граней
+        std::vector<uint8_t>  faces;   // 6 байт на слот
+    };
+
+    int sizeX = 0, sizeY = 0, sizeZ = 0;
+    int nx = 0, ny = 0, nz = 0;        // число чанков по осям
+    bool rayTraced_ = false;
+    std::vector<Chunk> chunks;
+
+    int chunkIndex(int x, int y, int z) const {
+        return ((x / VOXEL_CHUNK_SIZE) * ny + y / VOXEL_CHUNK_SIZE) * nz + z / VOXEL_CHUNK_SIZE;
+    }
+    static int cellIndex(int x, int y, int z) {
+        return ((x % VOXEL_CHUNK_SIZE) * VOXEL_CHUNK_SIZE + y % VOXEL_CHUNK_SIZE) * VOXEL_CHUNK_SIZE + z % VOXEL_CHUNK_SIZE;
+    }
+    int3 chunkOrigin(int c) const {
+        return int3(c / (ny * nz), (c / nz) % ny, c % nz) * VOXEL_CHUNK_SIZE;
+    }
+
+    template<class World>
+    bool solid(const World& world, int x, int y, int z) const {
+        return x >= 0 && y >= 0 && z >= 0 && x < sizeX && y < sizeY && z < sizeZ && world.isSolid(x, y, z);
+    }
+
+    // Пересчитывает 6 граней вокселя и кладет их в слот его чанка
+    template<class World>
+    void bakeVoxel(const World& world, int x, int y, int z) {
+        uint8_t faces[6];
+        bool exposed = false;
+        for (int face = 0; face < 6; face++) {
+            faces[face] = 0xFF;
+            const int3 n = VOXEL_FACE_NORMALS[face];
+            const int3 front(x + n.x, y + n.y, z + n.z);
+            if (!solid(world, x, y, z) || solid(world, front.x, front.y, front.z)) continue;
+            exposed = true;
+            faces[face] = bakeFace(world, int3(x, y, z), face);
+        }
+
+        Chunk& chunk = chunks[chunkIndex(x, y, z)];
+        const int cell = cellIndex(x, y, z);
+        if (!exposed && (chunk.slot.empty() || chunk.slot[cell] == NO_SLOT)) return;
+        if (chunk.slot.empty()) chunk.slot.assign(VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE, NO_SLOT);
+        if (chunk.slot[cell] == NO_SLOT) {
+            chunk.slot[cell] = (uint16_t)(chunk.faces.size() / 6);
+            chunk.faces.resize(chunk.faces.size() + 6);
+        }
+        std::copy(faces, faces + 6, chunk.faces.begin() + chunk.slot[cell] * 6);
+    }
+
+    // 4 угла грани face вокселя v: угол i лежит на стороне (i & 1 ? +u : -u, i & 2 ? +v : -v),
+    // u, v - оси (axis + 1) % 3 и (axis + 2) % 3
+    template<class World>
+    uint8_t bakeFace(const World& world, const int3& v, int face) const {
+        const int axis = face / 2;
+        const int3 n = VOXEL_FACE_NORMALS[face];
+        const int3 front = v + n;
+        int3 du(0), dv(0);
+        du[(axis + 1) % 3] = 1;
+        dv[(axis + 2) % 3] = 1;
+
+        const float visibility = rayTraced_ ? rayVisibility(world, v, face) : 1.0f;
+        uint8_t corners = 0;
+        for (int i = 0; i < 4; i++) {
+            const int3 su = (i & 1) ? du : int3(0) - du;
+            const int3 sv = (i & 2) ? dv : int3(0) - dv;
+            const int3 a = front + su, b = front + sv, c = front + su + sv;
+            const int side1 = solid(world, a.x, a.y, a.z) ? 1 : 0;
+            const int side2 = solid(world, b.x, b.y, b.z) ? 1 : 0;
+            const int corner = solid(world, c.x, c.y, c.z) ? 1 : 0;
+            int level = (side1 && side2) ? 0 : 3 - (side1 + side2 + corner);
+            if (rayTraced_) level = (int)lroundf(level * visibility);
+            corners |= (uint8_t)(level << (2 * i));
+        }
+        return corners;
+    }
+
+    // Доля коротких лучей из центра грани, не встретивших твердого вокселя.
+    // Направления - фиксированная спираль по полусфере, поэтому запекание
+    // детерминировано и пересчет после правки совпадает с полным.
+    template<class World>
+    float rayVisibility(const World& world, const int3& v, int face) const {
+        const int axis = face / 2;
+        const int3 n = VOXEL_FACE_NORMALS[face];
+        const float3 normal((float)n.x, (float)n.y, (float)n.z);
+        float3 u(0.0f), w(0.0f);
+        u[(axis + 1) % 3] = 1.0f;
+        w[(axis + 2) % 3] = 1.0f;
+
+        // Координаты сетки -> мировые, как ждет rayOccluded
+        const float3 center = float3((float)v.x + 0.5f, (float)v.y + 0.5f, (float)v.z + 0.5f) + normal * 0.501f
+                            - float3(sizeX / 2.0f, 0.0f, sizeZ / 2.0f);
+        int open = 0;
+        for (int i = 0; i < AO_RAY_COUNT; i++) {
+            const float h = (i + 0.5f) / AO_RAY_COUNT;                  // высота над гранью, cos угла
+            const float r = sqrtf(1.0f - h * h);
+            const float phi = 2.39996323f * i;                          // золотой угол
+            const float3 dir = normal * h + u * (r * cosf(phi)) + w * (r * sinf(phi));
+            open += world.rayOccluded(center, dir, AO_RAY_DIST) ? 0 : 1;
+        }
+        return (float)open / AO_RAY_COUNT;
+    }
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/voxel_mesher.h"
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using LiteMath::float3;
+using LiteMath::int3;
+
+// ============ КЭШ ОСВЕЩЕННОСТИ ГРАНЕЙ ============
+// Рассеянный (непрямой) свет по граням вокселей в мировом пространстве.
+// Каждый кадр фиксированный бюджет IRRADIANCE_RAYS_PER_FRAME стохастических
+// лучей раздается видимым граням (по решетке экрана), каждый луч - одна
+// косинусная выборка полусферы над гранью. Выборки копятся во времени
+// скользящим средним с окном до IRRADIANCE_MAX_SAMPLES, так что цена кадра
+// не зависит от разрешения, а после правок мира значения сами сходятся к
+// новым. Попадание вторичного луча освещается с учетом того же кэша,
+// поэтому за несколько кадров набираются и многократные отражения.
+//
+// Хранение - хеш-таблица с открытой адресацией (линейное пробирование) на
+// IRRADIANCE_CAPACITY записей, ключ - (x, y, z, грань) в координатах сетки.
+// Грани, давно не получавшие выборок, вытесняются при заполнении таблицы.
+static constexpr int   IRRADIANCE_RAYS_PER_FRAME = 4096;
+static constexpr int   IRRADIANCE_MIN_SAMPLES    = 4;         // до этого грань освещается константой
+static constexpr int   IRRADIANCE_MAX_SAMPLES    = 64;
+static constexpr int   IRRADIANCE_CAPACITY       = 1 << 17;   // степень двойки
+static constexpr int   IRRADIANCE_MAX_AGE        = 256;       // кадров без обращений до вытеснения
+static constexpr float IRRADIANCE_SKY_R = 0.20f;              // яркость неба для промахнувшихся лучей
+static constexpr float IRRADIANCE_SKY_G = 0.25f;
+static constexpr float IRRADIANCE_SKY_B = 0.30f;
+
+// Хеш целого для выборок: детерминирован по кадру и номеру луча
+inline uint32_t hashUint32(uint32_t x) {
+    x ^= x >> 16; x *= 0x7feb352dU;
+    x ^= x >> 15; x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+class IrradianceCache {
+public:
+    IrradianceCache() : slots(IRRADIANCE_CAPACITY) {}
+
+    // Освещенность грани face (порядок VOXEL_FACE_NORMALS) вокселя, false - выборок пока мало
+    bool lookup(const int3& voxel, int face, float3& irradiance) const {
+        const uint64_t key = faceKey(voxel, face);
+        for (uint32_t i = slotIndex(key);; i = (i + 1) & MASK) {
+            const Slot& slot = slots[i];
+            if (slot.key == EMPTY) return false;
+            if (slot.key == key) {
+                if (slot.samples < IRRADIANCE_MIN_SAMPLES) return false;
+                irradiance = float3(slot.r, slot.g, slot.b);
+                return true;
+            }
+        }
+    }
+
+    // Добавляет выборку освещенности грани; вызывается из одного потока
+    void accumulate(const int3& voxel, int face, const float3& sample) {
+        if (used * 2 >= IRRADIANCE_CAPACITY) evict();
+        const uint64_t key = faceKey(voxel, face);
+        uint32_t i = slotIndex(key);
+        while (slots[i].key != EMPTY && slots[i].key != key) i = (i + 1) & MASK;
+        Slot& slot = slots[i];
+        if (slot.key == EMPTY) {
+            slot = Slot();
+            slot.key = key;
+            used++;
+        }
+        slot.samples = (uint16_t)std::min(slot.samples + 1, IRRADIANCE_MAX_SAMPLES);
+        const float w = 1.0f / slot.samples;
+        slot.r += (sample.x - slot.r) * w;
+        slot.g += (sample.y - slot.g) * w;
+        slot.b += (sample.z - slot.b) * w;
+        slot.lastFrame = frame_;
+    }
+
+    // Начало нового кадра выборок
+    void nextFrame() { frame_++; }
+    uint32_t frame() const { return frame_; }
+
+    void clear() {
+        std::fill(slots.begin(), slots.end(), Slot());
+        used = 0;
+    }
+
+    int size() const { return used; }
+    size_t getMemoryUsage() const { return slots.size() * sizeof(Slot); }
+
+private:
+    static constexpr uint64_t EMPTY = ~0ULL;
+    static constexpr uint32_t MASK  = IRRADIANCE_CAPACITY - 1;
+
+    struct Slot {
+        uint64_t key = EMPTY;
+        float r = 0.0f, g = 0.0f, b = 0.0f;  // скользящее среднее выборок
+        uint16_t samples = 0;
+        uint16_t lastFrame = 0;              // младшие биты номера кадра последней выборки
+    };
+
+    std::vector<Slot> slots;
+    int used = 0;
+    uint32_t frame_ = 0;
+
+    // 20 бит на координату, 3 на грань
+    static uint64_t faceKey(const int3& v, int face) {
+        return ((uint64_t)(v.x & 0xFFFFF) << 43) | ((uint64_t)(v.y & 0xFFFFF) << 23) |
+               ((uint64_t)(v.z & 0xFFFFF) << 3) | (uint64_t)face;
+    }
+    static uint32_t slotIndex(uint64_t key) {
+        key *= 0x9E3779B97F4A7C15ULL;
+        return (uint32_t)(key >> 40) & MASK;
+    }
+
+    // Перестраивает таблицу без граней старше IRRADIANCE_MAX_AGE кадров; если
+    // свежих граней все равно много, окно возраста сужается, пока их не
+    // останется не больше четверти таблицы
+    void evict() {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(IRRADIANCE_CAPACITY, Slot());
+        used = 0;
+        int maxAge = IRRADIANCE_MAX_AGE;
+        auto age = [&](const Slot& s) { return (int)(uint16_t)((uint16_t)frame_ - s.lastFrame); };
+        int alive = 0;
+        for (const Slot& s : old) alive += s.key != EMPTY && age(s) <= maxAge;
+        while (alive * 4 > IRRADIANCE_CAPACITY && maxAge > 0) {
+            maxAge /= 2;
+            alive = 0;
+            for (const Slot& s : old) alive += s.key != EMPTY && age(s) <= maxAge;
+        }
+        for (const Slot& s : old) {
+            if (s.key == EMPTY || age(s) > maxAge) continue;
+            uint32_t i = slotIndex(s.key);
+            while (slots[i].key != EMPTY) i = (i + 1) & MASK;
+            slots[i] = s;
+            used++;
+        }
+    }
+};
@@ -0,0 +1,290 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/voxel_world.h"
+#include "utils/voxel_mesher.h"
+#include "utils/material_table.h"
+
+#include <omp.h>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <array>
+
+using LiteMath::int3;
+
+// ============ РАСПРОСТРАНЕНИЕ СВЕТА ПО ВОКСЕЛЯМ ============
+// Два канала по 4 бита на воксель: небесный свет (старший полубайт) и свет
+// излучающих материалов (младший). Свет течет в прозрачные клетки (воздух и
+// материалы с флагом transparent), теряя уровень за шаг; небесный свет 15
+// падает вниз по воздуху без потерь. Непрозрачные клетки темные, кроме
+// излучателей: у них блочный уровень равен MaterialInfo::emission.
+//
+// Полный расчет - волновой BFS по чанкам VOXEL_CHUNK_SIZE^3: за раунд каждый
+// чанк параллельно дорабатывает свою очередь, а свет, вышедший за его
+// границу, копится в потоковых корзинах соседа и сливается между раундами.
+// Уровни только растут, поэтому порядок обработки не влияет на результат.
+//
+// Правки - последовательный BFS с очередями удаления и добавления: удаление
+// гасит свет, зависевший от измененной клетки, и собирает освещенную границу,
+// из которой затем свет растекается заново.
+static constexpr int LIGHT_MAX = 15;
+
+// Яркость уровня света: каждый шаг от максимума - 0.8 (как в Minecraft)
+inline float lightLevelBrightness(int level) {
+    static const auto table = []() {
+        std::array<float, LIGHT_MAX + 1> t{};
+        for (int i = 0; i <= LIGHT_MAX; i++) t[i] = powf(0.8f, (float)(LIGHT_MAX - i));
+        return t;
+    }();
+    return table[level];
+}
+
+class VoxelLight {
+public:
+    enum Channel { SKY = 0, BLOCK = 1 };
+
+    template<class World>
+    void build(const World& world) {
+        sizeX = world.getSizeX();
+        sizeY = world.getSizeY();
+        sizeZ = world.getSizeZ();
+        nx = (sizeX + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE;
+        ny = (sizeY + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE;
+        nz = (sizeZ + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE;
+        levels.assign((size_t)nx * ny * nz * CHUNK_CELLS, 0);
+        propagateAll(world, SKY);
+        propagateAll(world, BLOCK);
+    }
+
+    // Пересчет после world.setVoxel(x, y, z, ...)
+    template<class World>
+    void update(const World& world, int x, int y, int z) {
+        if (!built() || !inside(x, y, z)) return;
+        for (int channel : {SKY, BLOCK}) {
+            std::vector<Node> removeQueue, addQueue;
+            removeQueue.push_back({int3(x, y, z), (uint8_t)get(x, y, z, channel)});
+            set(x, y, z, channel, 0);
+            removeLight(world, channel, removeQueue, addQueue);
+
+            // Новое состояние клетки: источник или проводник света соседей
+            if (channel == SKY && y == sizeY - 1 && transparent(world, x, y, z)) {
+                set(x, y, z, SKY, LIGHT_MAX);
+                addQueue.push_back({int3(x, y, z), LIGHT_MAX});
+            }
+            if (channel == BLOCK && emission(world, x, y, z) > 0) {
+                set(x, y, z, BLOCK, emission(world, x, y, z));
+                addQueue.push_back({int3(x, y, z), (uint8_t)emission(world, x, y, z)});
+            }
+            if (transparent(world, x, y, z)) {
+                for (const int3& n : VOXEL_FACE_NORMALS) {
+                    const int3 p(x + n.x, y + n.y, z + n.z);
+                    if (inside(p.x, p.y, p.z) && get(p.x, p.y, p.z, channel) > 0)
+                        addQueue.push_back({p, (uint8_t)get(p.x, p.y, p.z, channel)});
+                }
+            }
+            addLight(world, channel, addQueue);
+        }
+    }
+
+    bool built() const { return !levels.empty(); }
+
+    int get(int x, int y, int z, int channel) const {
+        const uint8_t v = levels[index(x, y, z)];
+        return channel == SKY ? (v >> 4) : (v & 0xF);
+    }
+
+    // Уровни в клетке p; вне мира открытое небо, под ним - темнота
+    void levelsAt(const int3& p, int& sky, int& block) const {
+        if (!inside(p.x, p.y, p.z)) {
+            sky = p.y >= 0 ? LIGHT_MAX : 0;
+            block = 0;
+            return;
+        }
+        sky = get(p.x, p.y, p.z, SKY);
+        block = get(p.x, p.y, p.z, BLOCK);
+    }
+
+    // Уровни в клетке перед гранью face вокселя (порядок VOXEL_FACE_NORMALS)
+    void faceLevels(const int3& voxel, int face, int& sky, int& block) const {
+        levelsAt(voxel + VOXEL_FACE_NORMALS[face], sky, block);
+    }
+
+    size_t getMemoryUsage() const { return levels.size(); }
+
+private:
+    static constexpr int CHUNK_CELLS = VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE;
+
+    struct Node {
+        int3    pos;
+        uint8_t level;
+    };
+    struct Incoming {
+        uint16_t cell;
+        uint8_t  level;
+    };
+
+    int sizeX = 0, sizeY = 0, sizeZ = 0;
+    int nx = 0, ny = 0, nz = 0;        // число чанков по осям
+    std::vector<uint8_t> levels;       // по чанкам: [чанк][клетка], небо << 4 | блок
+
+    bool inside(int x, int y, int z) const {
+        return x >= 0 && y >= 0 && z >= 0 && x < sizeX && y < sizeY && z < sizeZ;
+    }
+    int chunkIndex(int x, int y, int z) const {
+        return ((x / VOXEL_CHUNK_SIZE) * ny + y / VOXEL_CHUNK_SIZE) * nz + z / VOXEL_CHUNK_SIZE;
+    }
+    static int cellIndex(int x, int y, int z) {
+        return ((x % VOXEL_CHUNK_SIZE) * VOXEL_CHUNK_SIZE + y % VOXEL_CHUNK_SIZE) * VOXEL_CHUNK_SIZE + z % VOXEL_CHUNK_SIZE;
+    }
+    size_t index(int x, int y, int z) const {
+        return (size_t)chunkIndex(x, y, z) * CHUNK_CELLS + cellIndex(x, y, z);
+    }
+    int3 chunkOrigin(int c) const {
+        return int3(c / (ny * nz), (c / nz) % ny, c % nz) * VOXEL_CHUNK_SIZE;
+    }
+    static int3 cellOffset(int cell) {
+        return int3(cell / (VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE), (cell / VOXEL_CHUNK_SIZE) % VOXEL_CHUNK_SIZE,
+                    cell % VOXEL_CHUNK_SIZE);
+    }
+
+    void set(int x, int y, int z, int channel, int level) {
+        uint8_t& v = levels[index(x, y, z)];
+        v = channel == SKY ? (uint8_t)((v & 0x0F) | (level << 4)) : (uint8_t)((v & 0xF0) | level);
+    }
+
+    template<class World>
+    static bool transparent(const World& world, int x, int y, int z) {
+        return materialTable()[world.getVoxel(x, y, z).type].transparent();
+    }
+    template<class World>
+    static int emission(const World& world, int x, int y, int z) {
+        const MaterialInfo& material = materialTable()[world.getVoxel(x, y, z).type];
+        return material.emissive() ? material.emission : 0;
+    }
+
+    // Уровень, который клетка с уровнем level передает соседу в направлении face
+    template<class World>
+    static int passedLevel(const World& world, int channel, int level, int face, const int3& to) {
+        const bool fallsThroughAir = channel == SKY && level == LIGHT_MAX && face == 2 &&
+                                     world.getVoxel(to.x, to.y, to.z).type == 0;
+        return fallsThroughAir ? LIGHT_MAX : level - 1;
+    }
+
+    // ---------- полный расчет ----------
+
+    template<class World>
+    void propagateAll(const World& world, int channel) {
+        const int chunkCount = nx * ny * nz;
+        std::vector<std::vector<uint16_t>> queues(chunkCount);
+
+        // Источники: верхний слой прозрачных клеток для неба, излучатели для блоков
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int c = 0; c < chunkCount; c++) {
+            const int3 base = chunkOrigin(c);
+            for (int x = base.x; x < std::min(base.x + VOXEL_CHUNK_SIZE, sizeX); x++)
+            for (int y = base.y; y < std::min(base.y + VOXEL_CHUNK_SIZE, sizeY); y++)
+            for (int z = base.z; z < std::min(base.z + VOXEL_CHUNK_SIZE, sizeZ); z++) {
+                const int level = channel == SKY ? (y == sizeY - 1 && transparent(world, x, y, z) ? LIGHT_MAX : 0)
+                                                 : emission(world, x, y, z);
+                if (level == 0) continue;
+                set(x, y, z, channel, level);
+                queues[c].push_back((uint16_t)cellIndex(x, y, z));
+            }
+        }
+
+        // Раунды: чанки дорабатывают свои очереди, переходы через границу - в корзины соседей
+        std::vector<std::vector<std::vector<Incoming>>> outboxes(omp_get_max_threads(),
+                                                                 std::vector<std::vector<Incoming>>(chunkCount));
+        for (bool pending = true; pending; ) {
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int c = 0; c < chunkCount; c++) {
+                if (queues[c].empty()) continue;
+                spreadInChunk(world, channel, c, queues[c], outboxes[omp_get_thread_num()]);
+            }
+
+            pending = false;
+            #pragma omp parallel for schedule(dynamic, 1) reduction(||:pending)
+            for (int c = 0; c < chunkCount; c++) {
+                const int3 base = chunkOrigin(c);
+                for (auto& outbox : outboxes) {
+                    for (const Incoming& in : outbox[c]) {
+                        const int3 p = base + cellOffset(in.cell);
+                        if (in.level <= get(p.x, p.y, p.z, channel)) continue;
+                        set(p.x, p.y, p.z, channel, in.level);
+                        queues[c].push_back(in.cell);
+                    }
+                    outbox[c].clear();
+                }
+                pending = pending || !queues[c].empty();
+            }
+        }
+    }
+
+    template<class World>
+    void spreadInChunk(const World& world, int channel, int c, std::vector<uint16_t>& queue,
+                       std::vector<std::vector<Incoming>>& outbox) {
+        const int3 base = chunkOrigin(c);
+        for (size_t head = 0; head < queue.size(); head++) {
+            const int3 p = base + cellOffset(queue[head]);
+            const int level = get(p.x, p.y, p.z, channel);
+            if (level <= 1) continue;
+            for (int face = 0; face < 6; face++) {
+                const int3 q = p + VOXEL_FACE_NORMALS[face];
+                if (!inside(q.x, q.y, q.z) || !transparent(world, q.x, q.y, q.z)) continue;
+                const int passed = passedLevel(world, channel, level, face, q);
+                if (chunkIndex(q.x, q.y, q.z) != c) {
+                    outbox[chunkIndex(q.x, q.y, q.z)].push_back({(uint16_t)cellIndex(q.x, q.y, q.z), (uint8_t)passed});
+                } else if (passed > get(q.x, q.y, q.z, channel)) {
+                    set(q.x, q.y, q.z, channel, passed);
+                    queue.push_back((uint16_t)cellIndex(q.x, q.y, q.z));
+                }
+            }
+        }
+        queue.clear();
+    }
+
+    // ---------- правки ----------
+
+    // Гасит свет, который мог прийти через клетки очереди; освещенная
+    // независимо граница уходит в addQueue
+    template<class World>
+    void removeLight(const World& world, int channel, std::vector<Node>& removeQueue, std::vector<Node>& addQueue) {
+        for (size_t head = 0; head < removeQueue.size(); head++) {
+            const Node node = removeQueue[head];
+            for (int face = 0; face < 6; face++) {
+                const int3 q = node.pos + VOXEL_FACE_NORMALS[face];
+                if (!inside(q.x, q.y, q.z)) continue;
+                const int level = get(q.x, q.y, q.z, channel);
+                if (level == 0) continue;
+                const bool dependent = transparent(world, q.x, q.y, q.z) &&
+                                       level <= passedLevel(world, channel, node.level, face, q) &&
+                                       !(channel == BLOCK && emission(world, q.x, q.y, q.z) > 0);
+                if (dependent) {
+                    set(q.x, q.y, q.z, channel, 0);
+                    removeQueue.push_back({q, (uint8_t)level});
+                } else {
+                    addQueue.push_back({q, (uint8_t)level});
+                }
+            }
+        }
+    }
+
+    template<class World>
+    void addLight(const World& world, int channel, std::vector<Node>& addQueue) {
+        for (size_t head = 0; head < addQueue.size(); head++) {
+            const int3 p = addQueue[head].pos;
+            const int level = get(p.x, p.y, p.z, channel);
+            if (level <= 1) continue;
+            for (int face = 0; face < 6; face++) {
+                const int3 q = p + VOXEL_FACE_NORMALS[face];
+                if (!inside(q.x, q.y, q.z) || !transparent(world, q.x, q.y, q.z)) continue;
+                const int passed = passedLevel(world, channel, level, face, q);
+                if (passed <= get(q.x, q.y, q.z, channel)) continue;
+                set(q.x, q.y, q.z, channel, passed);
+                addQueue.push_back({q, (uint8_t)passed});
+            }
+        }
+    }
+};
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/mesh.h"
+#include "utils/voxel_world.h"
+
+#include <cstdint>
+#include <cfloat>
+#include <vector>
+#include <algorithm>
+
+using LiteMath::float2;
+using LiteMath::float3;
+using LiteMath::float4;
+using LiteMath::int3;
+
+// ============ ПОВЕРХНОСТЬ ВОКСЕЛЬНОГО МИРА ============
+// Видимые грани вокселей (твердый воксель рядом с воздухом) в виде квадов
+// cmesh4::SimpleMesh: 4 вершины и 2 треугольника на грань, нормаль грани в
+// vNorm4f, UV квада в vTexCoord2f, тип вокселя в matIndices. Мир режется на
+// чанки VOXEL_CHUNK_SIZE^3, у каждого свой меш и AABB для отсечения.
+static constexpr int VOXEL_CHUNK_SIZE = 16;
+
+struct VoxelChunkMesh {
+    int3   voxelMin;            // диапазон вокселей чанка в координатах сетки [min, max)
+    int3   voxelMax;
+    float3 boundsMin;           // AABB граней в мировых координатах
+    float3 boundsMax;
+    cmesh4::SimpleMesh mesh;
+};
+
+// Направления граней: -X, +X, -Y, +Y, -Z, +Z
+static const int3 VOXEL_FACE_NORMALS[6] = {
+    int3(-1, 0, 0), int3(1, 0, 0), int3(0, -1, 0), int3(0, 1, 0), int3(0, 0, -1), int3(0, 0, 1)
+};
+
+// Грань вокселя voxel, ближайшая к точке gridPos (координаты сетки), -
+// грань, через которую луч вошел в воксель
+inline int nearestVoxelFace(const int3& voxel, const float3& gridPos) {
+    const float3 local = gridPos - float3((float)voxel.x, (float)voxel.y, (float)voxel.z);
+    int face = 0;
+    float best = local.x;
+    for (int axis = 0; axis < 3; axis++) {
+        if (local[axis] < best)        { best = local[axis];        face = 2 * axis; }
+        if (1.0f - local[axis] < best) { best = 1.0f - local[axis]; face = 2 * axis + 1; }
+    }
+    return face;
+}
+
+// Добавляет квад грани face с углами c0..c3 (обход против часовой стрелки, если
+// смотреть снаружи), текстурными координатами uv0..uv3 и материалом material
+inline void appendVoxelQuad(cmesh4::SimpleMesh& mesh, int face, const float3 c[4], const float2 uv[4],
+                            uint32_t material) {
+    const uint32_t base = (uint32_t)mesh.vPos4f.size();
+    const int3 n = VOXEL_FACE_NORMALS[face];
+    const float4 normal((float)n.x, (float)n.y, (float)n.z, 0.0f);
+    const float4 tangent = (n.x != 0) ? float4(0, 0, 1, 0) : float4(1, 0, 0, 0);
+
+    for (int i = 0; i < 4; i++) {
+        mesh.vPos4f.push_back(float4(c[i].x, c[i].y, c[i].z, 1.0f));
+        mesh.vNorm4f.push_back(normal);
+        mesh.vTang4f.push_back(tangent);
+        mesh.vTexCoord2f.push_back(uv[i]);
+    }
+    const uint32_t quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+    mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+    mesh.matIndices.push_back(material);
+    mesh.matIndices.push_back(material);
+}
+
+// Углы грани face размера du x dv, начинающейся в точке p сетки, с обходом
+// против часовой стрелки снаружи. Оси u, v для каждого направления выбраны так,
+// что u x v смотрит вдоль нормали. UV идут в вокселях, чтобы текстура
+// повторялась на объединенных гранях.
+inline void voxelFaceCorners(int face, const float3& p, float du, float dv, float3 c[4], float2 uv[4]) {
+    const int axis = face / 2;
+    const bool positive = (face & 1) != 0;
+    const int uAxis = (axis + 1) % 3;
+    const int vAxis = (axis + 2) % 3;
+
+    float3 base = p;
+    if (positive) base[axis] += 1.0f;
+    float3 u(0.0f), v(0.0f);
+    u[uAxis] = du;
+    v[vAxis] = dv;
+
+    if (positive) {
+        c[0] = base; c[1] = base + u; c[2] = base + u + v; c[3] = base + v;
+        uv[0] = float2(0, 0); uv[1] = float2(du, 0); uv[2] = float2(du, dv); uv[3] = float2(0, dv);
+    } else {
+        c[0] = base; c[1] = base + v; c[2] = base + u + v; c[3] = base + u;
+        uv[0] = float2(0, 0); uv[1] = float2(0, dv); uv[2] = float2(du, dv); uv[3] = float2(du, 0);
+    }
+}
+
+inline void updateChunkBounds(VoxelChunkMesh& chunk) {
+    chunk.boundsMin = float3(FLT_MAX);
+    chunk.boundsMax = float3(-FLT_MAX);
+    for (const float4& p : chunk.mesh.vPos4f) {
+        chunk.boundsMin = LiteMath::min(chunk.boundsMin, LiteMath::to_float3(p));
+        chunk.boundsMax = LiteMath::max(chunk.boundsMax, LiteMath::to_float3(p));
+    }
+}
+
+// Разбиение мира на чанки (без геометрии)
+template<class World>
+std::vector<VoxelChunkMesh> makeVoxelChunks(const World& world) {
+    std::vector<VoxelChunkMesh> chunks;
+    for (int x = 0; x < world.getSizeX(); x += VOXEL_CHUNK_SIZE)
+    for (int y = 0; y < world.getSizeY(); y += VOXEL_CHUNK_SIZE)
+    for (int z = 0; z < world.getSizeZ(); z += VOXEL_CHUNK_SIZE) {
+        VoxelChunkMesh chunk;
+        chunk.voxelMin = int3(x, y, z);
+        chunk.voxelMax = int3(std::min(x + VOXEL_CHUNK_SIZE, world.getSizeX()),
+                              std::min(y + VOXEL_CHUNK_SIZE, world.getSizeY()),
+                              std::min(z + VOXEL_CHUNK_SIZE, world.getSizeZ()));
+        chunks.push_back(std::move(chunk));
+    }
+    return chunks;
+}
+
+// Наивное извлечение: по квадру на каждую открытую грань. Вершины в мировых
+// координатах (как у rayCast). Чанки обрабатываются параллельно, пустые
+// чанки из результата удаляются. Соседние квады делят вершины точно, без
+// T-образных стыков, поэтому для растеризации берется именно эта поверхность.
+template<class World>
+std::vector<VoxelChunkMesh> extractVoxelSurface(const World& world) {
+    std::vector<VoxelChunkMesh> chunks = makeVoxelChunks(world);
+    const float3 offset = voxelGridOffset(world);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int ci = 0; ci < (int)chunks.size(); ci++) {
+        VoxelChunkMesh& chunk = chunks[ci];
+        for (int x = chunk.voxelMin.x; x < chunk.voxelMax.x; x++)
+        for (int y = chunk.voxelMin.y; y < chunk.voxelMax.y; y++)
+        for (int z = chunk.voxelMin.z; z < chunk.voxelMax.z; z++) {
+            if (!world.isSolid(x, y, z)) continue;
+            const uint32_t material = world.getVoxel(x, y, z).type;
+            for (int face = 0; face < 6; face++) {
+                const int3 n = VOXEL_FACE_NORMALS[face];
+                if (world.isSolid(x + n.x, y + n.y, z + n.z)) continue;
+                float3 c[4];
+                float2 uv[4];
+                voxelFaceCorners(face, float3((float)x, (float)y, (float)z) - offset, 1.0f, 1.0f, c, uv);
+                appendVoxelQuad(chunk.mesh, face, c, uv, material);
+            }
+        }
+        updateChunkBounds(chunk);
+    }
+
+    chunks.erase(std::remove_if(chunks.begin(), chunks.end(),
+                                [](const VoxelChunkMesh& c) { return c.mesh.TrianglesNum() == 0; }),
+                 chunks.end());
+    return chunks;
+}
+
+// ============ ЖАДНОЕ ОБЪЕДИНЕНИЕ ГРАНЕЙ ============
+// Для каждого направления грани и каждого слоя чанка строится маска материалов
+// открытых граней, и прямоугольники с одинаковым материалом объединяются в
+// один квад: сначала растягиваем по u, затем по v, пока вся строка совпадает.
+// Квады не выходят за границы чанка, так что чанки по-прежнему независимы.
+template<class World>
+void greedyMeshChunk(const World& world, const float3& offset, VoxelChunkMesh& chunk) {
+    const int3 lo = chunk.voxelMin, hi = chunk.voxelMax;
+    std::vector<uint32_t> mask(VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE);
+
+    for (int face = 0; face < 6; face++) {
+        const int axis  = face / 2;
+        const int uAxis = (axis + 1) % 3;
+        const int vAxis = (axis + 2) % 3;
+        const int3 n = VOXEL_FACE_NORMALS[face];
+        const int sizeU = hi[uAxis] - lo[uAxis];
+        const int sizeV = hi[vAxis] - lo[vAxis];
+
+        for (int d = lo[axis]; d < hi[axis]; d++) {
+            // Маска слоя: тип вокселя, если его грань face открыта, иначе 0
+            for (int j = 0; j < sizeV; j++)
+            for (int i = 0; i < sizeU; i++) {
+                int3 p;
+                p[axis] = d; p[uAxis] = lo[uAxis] + i; p[vAxis] = lo[vAxis] + j;
+                uint32_t material = 0;
+                if (world.isSolid(p.x, p.y, p.z) && !world.isSolid(p.x + n.x, p.y + n.y, p.z + n.z))
+                    material = world.getVoxel(p.x, p.y, p.z).type;
+                mask[j * sizeU + i] = material;
+            }
+
+            for (int j = 0; j < sizeV; j++)
+            for (int i = 0; i < sizeU; ) {
+                const uint32_t material = mask[j * sizeU + i];
+                if (material == 0) { i++; continue; }
+
+                int w = 1;
+                while (i + w < sizeU && mask[j * sizeU + i + w] == material) w++;
+                int h = 1;
+                for (; j + h < sizeV; h++) {
+                    bool rowMatches = true;
+                    for (int k = 0; k < w && rowMatches; k++)
+                        rowMatches = (mask[(j + h) * sizeU + i + k] == material);
+                    if (!rowMatches) break;
+                }
+                for (int jj = j; jj < j + h; jj++)
+                    std::fill(mask.begin() + jj * sizeU + i, mask.begin() + jj * sizeU + i + w, 0u);
+
+                float3 p;
+                p[axis] = (float)d; p[uAxis] = (float)(lo[uAxis] + i); p[vAxis] = (float)(lo[vAxis] + j);
+                float3 c[4];
+                float2 uv[4];
+                voxelFaceCorners(face, p - offset, (float)w, (float)h, c, uv);
+                appendVoxelQuad(chunk.mesh, face, c, uv, material);
+                i += w;
+            }
+        }
+    }
+    updateChunkBounds(chunk);
+}
+
+template<class World>
+std::vector<VoxelChunkMesh> extractVoxelSurfaceGreedy(const World& world) {
+    std::vector<VoxelChunkMesh> chunks = makeVoxelChunks(world);
+    const float3 offset = voxelGridOffset(world);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int ci = 0; ci < (int)chunks.size(); ci++)
+        greedyMeshChunk(world, offset, chunks[ci]);
+
+    chunks.erase(std::remove_if(chunks.begin(), chunks.end(),
+                                [](const VoxelChunkMesh& c) { return c.mesh.TrianglesNum() == 0; }),
+                 chunks.end());
+    return chunks;
+}
+
+// Склейка мешей чанков в один (индексы сдвигаются на число вершин предыдущих чанков)
+inline cmesh4::SimpleMesh mergeVoxelChunks(const std::vector<VoxelChunkMesh>& chunks) {
+    size_t vertices = 0, indices = 0;
+    for (const VoxelChunkMesh& chunk : chunks) {
+        vertices += chunk.mesh.VerticesNum();
+        indices  += chunk.mesh.IndicesNum();
+    }
+    cmesh4::SimpleMesh mesh(vertices, indices);
+
+    size_t v = 0, i = 0;
+    for (const VoxelChunkMesh& chunk : chunks) {
+        const cmesh4::SimpleMesh& m = chunk.mesh;
+        std::copy(m.vPos4f.begin(), m.vPos4f.end(), mesh.vPos4f.begin() + v);
+        std::copy(m.vNorm4f.begin(), m.vNorm4f.end(), mesh.vNorm4f.begin() + v);
+        std::copy(m.vTang4f.begin(), m.vTang4f.end(), mesh.vTang4f.begin() + v);
+        std::copy(m.vTexCoord2f.begin(), m.vTexCoord2f.end(), mesh.vTexCoord2f.begin() + v);
+        for (size_t k = 0; k < m.IndicesNum(); k++)
+            mesh.indices[i + k] = m.indices[k] + (uint32_t)v;
+        std::copy(m.matIndices.begin(), m.matIndices.end(), mesh.matIndices.begin() + i / 3);
+        v += m.VerticesNum();
+        i += m.IndicesNum();
+    }
+    return mesh;
+}
+
+// Меш всего мира из объединенных граней; тип бэкенда определяется один раз
+inline cmesh4::SimpleMesh buildVoxelWorldMesh(const IVoxelWorld& world) {
+    return dispatchVoxelWorld(world, [](const auto& w) {
+        return mergeVoxelChunks(extractVoxelSurfaceGreedy(w));
+    });
+}
+
+// Экспорт мира в OBJ (материалы - типы вокселей, см. SaveMeshToObj)
+inline void exportVoxelWorldObj(const IVoxelWorld& world, const char* fileName) {
+    cmesh4::SaveMeshToObj(fileName, buildVoxelWorldMesh(world));
+}
@@ -0,0 +1,334 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/public_camera.h"
+#include "utils/voxel_world.h"
+#include "utils/voxel_mesher.h"
+#include "utils/voxel_render.h"
+#include "utils/ray_generator.h"
+
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <algorithm>
+
+using LiteMath::float2;
+using LiteMath::float3;
+
+// ============ РАСТЕРИЗАЦИЯ ============
+// Первичная видимость без трассировки: видимые чанки поверхности (см.
+// extractVoxelSurface) проецируются на экран, треугольники раскладываются по
+// корзинам RASTER_BIN_SIZE x RASTER_BIN_SIZE и растеризуются потайлово с
+// буфером глубины тайла. Затем пиксель тайла восстанавливает точку попадания и
+// воксель и освещается теми же данными мира, что и при трассировке, так что
+// лучи для вторичных эффектов можно пускать из восстановленной точки.
+// Растеризуются только воксели: пиксели, где видна полупрозрачная среда (при
+// включенной полупрозрачности), меш ближе грани или на фоне неба, трассируются
+// полным лучом.
+static constexpr int   RASTER_BIN_SIZE = 32;
+static constexpr float RASTER_NEAR     = 0.05f;   // ближняя плоскость отсечения (глубина вдоль взгляда)
+
+// Треугольник после проекции: экранные координаты (центр пикселя x - это x + 0.5)
+// и 1/глубина в вершинах. Обход приведен к положительной площади.
+struct RasterTriangle {
+    float2 p[3];
+    float  invDepth[3];
+    float  area;                // удвоенная площадь на экране
+    int    x0, y0, x1, y1;      // пиксели, центры которых в AABB, включительно
+    float3 boundsMin;           // AABB исходного треугольника в координатах сетки
+    float3 boundsMax;
+    float3 normal;              // нормаль грани
+};
+
+// Буферы растеризатора, переиспользуемые между кадрами. Треугольники и корзины
+// ведутся отдельно для каждого потока, чтобы настройка шла без синхронизации.
+struct RasterState {
+    std::vector<std::vector<RasterTriangle>> triangles;          // [поток]
+    std::vector<std::vector<std::vector<uint32_t>>> bins;        // [поток][корзина]
+    int visibleChunks   = 0;    // статистика последнего кадра
+    int rasterTriangles = 0;
+};
+
+// Проекция в однородные координаты: (px*s, py*s, s), s - глубина вдоль взгляда.
+// Линейна по точке, поэтому отсечение ближней плоскостью делается до деления.
+struct RasterProjection {
+    float3 origin, forward;
+    float3 axisX, axisY;        // px*s = dot(v, axisX) + biasX*s
+    float  biasX, biasY;
+
+    explicit RasterProjection(const RayGenerator& rayGen) : origin(rayGen.origin), forward(rayGen.forward) {
+        axisX = rayGen.dx / LiteMath::dot(rayGen.dx, rayGen.dx);
+        axisY = rayGen.dy / LiteMath::dot(rayGen.dy, rayGen.dy);
+        biasX = 0.5f - LiteMath::dot(rayGen.dir00, axisX);
+        biasY = 0.5f - LiteMath::dot(rayGen.dir00, axisY);
+    }
+
+    float3 toHomogeneous(const float3& p) const {
+        const float3 v = p - origin;
+        const float s = LiteMath::dot(v, forward);
+        return float3(LiteMath::dot(v, axisX) + biasX * s, LiteMath::dot(v, axisY) + biasY * s, s);
+    }
+};
+
+// Пирамида видимости: четыре боковые плоскости через камеру и ближняя плоскость
+struct RasterFrustum {
+    float3 origin, forward;
+    float3 planes[4];           // внутренние нормали боковых плоскостей
+
+    explicit RasterFrustum(const RayGenerator& rayGen) : origin(rayGen.origin), forward(rayGen.forward) {
+        const float W = (float)rayGen.width, H = (float)rayGen.height;
+        const float3 c00 = rayGen.directionAt(0, 0), c10 = rayGen.directionAt(W, 0);
+        const float3 c01 = rayGen.directionAt(0, H), c11 = rayGen.directionAt(W, H);
+        const float3 edges[4][2] = { {c00, c01}, {c01, c11}, {c11, c10}, {c10, c00} };
+        for (int i = 0; i < 4; i++) {
+            planes[i] = LiteMath::cross(edges[i][0], edges[i][1]);
+            if (LiteMath::dot(planes[i], forward) < 0.0f) planes[i] = -planes[i];
+        }
+    }
+
+    // false, если AABB целиком снаружи одной из плоскостей
+    bool intersects(const float3& mn, const float3& mx) const {
+        for (int i = 0; i <= 4; i++) {
+            const float3 n = (i < 4) ? planes[i] : forward;
+            const float3 far(n.x >= 0 ? mx.x : mn.x, n.y >= 0 ? mx.y : mn.y, n.z >= 0 ? mx.z : mn.z);
+            const float limit = (i < 4) ? 0.0f : RASTER_NEAR;
+            if (LiteMath::dot(n, far - origin) < limit) return false;
+        }
+        return true;
+    }
+};
+
+// Отсечение многоугольника в однородных координатах плоскостью s >= RASTER_NEAR.
+// Треугольник дает не больше 4 вершин.
+inline int clipNearPlane(const float3 in[3], float3 out[4]) {
+    int count = 0;
+    for (int i = 0; i < 3; i++) {
+        const float3& a = in[i];
+        const float3& b = in[(i + 1) % 3];
+        const bool aInside = a.z >= RASTER_NEAR;
+        const bool bInside = b.z >= RASTER_NEAR;
+        if (aInside) out[count++] = a;
+        if (aInside != bInside) {
+            const float t = (RASTER_NEAR - a.z) / (b.z - a.z);
+            out[count++] = a + (b - a) * t;
+        }
+    }
+    return count;
+}
+
+// Настройка экранного треугольника и раскладка его по корзинам потока
+inline void binRasterTriangle(const float3 h[3], const RasterTriangle& source, int W, int H, int binsX,
+                              std::vector<RasterTriangle>& triangles,
+                              std::vector<std::vector<uint32_t>>& bins) {
+    RasterTriangle tri = source;
+    for (int i = 0; i < 3; i++) {
+        tri.invDepth[i] = 1.0f / h[i].z;
+        tri.p[i] = float2(h[i].x * tri.invDepth[i], h[i].y * tri.invDepth[i]);
+    }
+    tri.area = (tri.p[1].x - tri.p[0].x) * (tri.p[2].y - tri.p[0].y) -
+               (tri.p[1].y - tri.p[0].y) * (tri.p[2].x - tri.p[0].x);
+    if (!(fabsf(tri.area) > 1e-8f)) return;
+    if (tri.area < 0.0f) {
+        std::swap(tri.p[1], tri.p[2]);
+        std::swap(tri.invDepth[1], tri.invDepth[2]);
+        tri.area = -tri.area;
+    }
+
+    const float minX = std::min(tri.p[0].x, std::min(tri.p[1].x, tri.p[2].x));
+    const float maxX = std::max(tri.p[0].x, std::max(tri.p[1].x, tri.p[2].x));
+    const float minY = std::min(tri.p[0].y, std::min(tri.p[1].y, tri.p[2].y));
+    const float maxY = std::max(tri.p[0].y, std::max(tri.p[1].y, tri.p[2].y));
+    if (maxX < 0.0f || maxY < 0.0f || minX > (float)W || minY > (float)H) return;
+    tri.x0 = std::max(0, (int)ceilf(minX - 0.5f));
+    tri.y0 = std::max(0, (int)ceilf(minY - 0.5f));
+    tri.x1 = std::min(W - 1, (int)floorf(maxX - 0.5f));
+    tri.y1 = std::min(H - 1, (int)floorf(maxY - 0.5f));
+    if (tri.x0 > tri.x1 || tri.y0 > tri.y1) return;
+
+    const uint32_t index = (uint32_t)triangles.size();
+    triangles.push_back(tri);
+    for (int by = tri.y0 / RASTER_BIN_SIZE; by <= tri.y1 / RASTER_BIN_SIZE; by++)
+        for (int bx = tri.x0 / RASTER_BIN_SIZE; bx <= tri.x1 / RASTER_BIN_SIZE; bx++)
+            bins[by * binsX + bx].push_back(index);
+}
+
+// Проекция, отсечение и раскладка по корзинам всех лицевых треугольников чанка
+inline void setupRasterChunk(const VoxelChunkMesh& chunk, const RasterProjection& proj, const float3& gridOffset,
+                             int W, int H, int binsX, std::vector<float3>& projected,
+                             std::vector<RasterTriangle>& triangles,
+                             std::vector<std::vector<uint32_t>>& bins) {
+    const cmesh4::SimpleMesh& mesh = chunk.mesh;
+    projected.resize(mesh.VerticesNum());
+    for (size_t i = 0; i < mesh.VerticesNum(); i++)
+        projected[i] = proj.toHomogeneous(LiteMath::to_float3(mesh.vPos4f[i]));
+
+    for (size_t t = 0; t < mesh.TrianglesNum(); t++) {
+        const uint32_t i0 = mesh.indices[t * 3 + 0];
+        const uint32_t i1 = mesh.indices[t * 3 + 1];
+        const uint32_t i2 = mesh.indices[t * 3 + 2];
+        const float3 p0 = LiteMath::to_float3(mesh.vPos4f[i0]);
+
+        // Грани вокселей смотрят наружу: задние отбрасываются до проекции
+        RasterTriangle tri;
+        tri.normal = LiteMath::to_float3(mesh.vNorm4f[i0]);
+        if (LiteMath::dot(tri.normal, p0 - proj.origin) >= 0.0f) continue;
+
+        const float3 h[3] = { projected[i0], projected[i1], projected[i2] };
+        if (h[0].z < RASTER_NEAR && h[1].z < RASTER_NEAR && h[2].z < RASTER_NEAR) continue;
+
+        const float3 p1 = LiteMath::to_float3(mesh.vPos4f[i1]);
+        const float3 p2 = LiteMath::to_float3(mesh.vPos4f[i2]);
+        tri.boundsMin = LiteMath::min(p0, LiteMath::min(p1, p2)) + gridOffset;
+        tri.boundsMax = LiteMath::max(p0, LiteMath::max(p1, p2)) + gridOffset;
+
+        if (h[0].z >= RASTER_NEAR && h[1].z >= RASTER_NEAR && h[2].z >= RASTER_NEAR) {
+            binRasterTriangle(h, tri, W, H, binsX, triangles, bins);
+            continue;
+        }
+        float3 poly[4];
+        const int n = clipNearPlane(h, poly);
+        for (int k = 1; k + 1 < n; k++) {
+            const float3 fan[3] = { poly[0], poly[k], poly[k + 1] };
+            binRasterTriangle(fan, tri, W, H, binsX, triangles, bins);
+        }
+    }
+}
+
+// Функция ребра a->b в точке (x, y). Считается всегда от меньшей (по
+// координатам) вершины, так что у двух треугольников с общим ребром значения
+// точно противоположны и пиксель на ребре не теряется ни одним из них.
+inline float rasterEdge(const float2& a, const float2& b, float x, float y) {
+    if (a.x < b.x || (a.x == b.x && a.y < b.y))
+        return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+    return -((a.x - b.x) * (y - b.y) - (a.y - b.y) * (x - b.x));
+}
+
+// Воксель под точкой грани: точка прижимается внутрь AABB треугольника
+// (против ошибок интерполяции на краях) и сдвигается на полклетки против нормали
+inline int3 rasterHitVoxel(const RasterTriangle& tri, float3 p) {
+    for (int a = 0; a < 3; a++) {
+        if (tri.boundsMax[a] - tri.boundsMin[a] > 2e-3f)
+            p[a] = std::min(std::max(p[a], tri.boundsMin[a] + 1e-3f), tri.boundsMax[a] - 1e-3f);
+        else
+            p[a] = tri.boundsMin[a];
+    }
+    p -= tri.normal * 0.5f;
+    return int3((int)floorf(p.x), (int)floorf(p.y), (int)floorf(p.z));
+}
+
+template<class World>
+void renderVoxelWorldRasterT(const Camera& camera, const World& world,
+                             const std::vector<VoxelChunkMesh>& chunks, RasterState& state,
+                             uint32_t* out_image, int W, int H,
+                             const RenderSettings& settings = RenderSettings()) {
+    const RayGenerator rayGen(camera, W, H);
+    const RasterProjection proj(rayGen);
+    const RasterFrustum frustum(rayGen);
+    const FrameShading shading(settings, rayGen);
+    const float3 gridOffset = voxelGridOffset(world);
+
+    const int binsX = (W + RASTER_BIN_SIZE - 1) / RASTER_BIN_SIZE;
+    const int binsY = (H + RASTER_BIN_SIZE - 1) / RASTER_BIN_SIZE;
+    const int threads = omp_get_max_threads();
+    state.triangles.resize(threads);
+    state.bins.resize(threads);
+
+    // Команда потоков может быть меньше omp_get_max_threads() (вложенный регион,
+    // OMP_DYNAMIC), а корзины прочих потоков - от прошлых кадров: читаем только team
+    int visibleChunks = 0, team = 1;
+    #pragma omp parallel
+    {
+        const int t = omp_get_thread_num();
+        if (t == 0) team = omp_get_num_threads();
+        std::vector<RasterTriangle>& triangles = state.triangles[t];
+        std::vector<std::vector<uint32_t>>& bins = state.bins[t];
+        triangles.clear();
+        bins.resize(binsX * binsY);
+        for (auto& bin : bins) bin.clear();
+        std::vector<float3> projected;
+
+        #pragma omp for schedule(dynamic, 1) reduction(+:visibleChunks)
+        for (int ci = 0; ci < (int)chunks.size(); ci++) {
+            if (!frustum.intersects(chunks[ci].boundsMin, chunks[ci].boundsMax)) continue;
+            visibleChunks++;
+            setupRasterChunk(chunks[ci], proj, gridOffset, W, H, binsX, projected, triangles, bins);
+        }
+    }
+    state.visibleChunks = visibleChunks;
+    state.rasterTriangles = 0;
+    for (int t = 0; t < team; t++) state.rasterTriangles += (int)state.triangles[t].size();
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int bin = 0; bin < binsX * binsY; bin++) {
+        const int bx0 = (bin % binsX) * RASTER_BIN_SIZE;
+        const int by0 = (bin / binsX) * RASTER_BIN_SIZE;
+        const int bx1 = std::min(bx0 + RASTER_BIN_SIZE, W) - 1;
+        const int by1 = std::min(by0 + RASTER_BIN_SIZE, H) - 1;
+
+        // Буфер глубины тайла хранит 1/глубину: 0 - бесконечность, больше - ближе
+        float depth[RASTER_BIN_SIZE * RASTER_BIN_SIZE];
+        const RasterTriangle* visible[RASTER_BIN_SIZE * RASTER_BIN_SIZE];
+        std::fill(depth, depth + RASTER_BIN_SIZE * RASTER_BIN_SIZE, 0.0f);
+        std::fill(visible, visible + RASTER_BIN_SIZE * RASTER_BIN_SIZE, nullptr);
+
+        for (int t = 0; t < team; t++) {
+            for (uint32_t index : state.bins[t][bin]) {
+                const RasterTriangle& tri = state.triangles[t][index];
+                const int x0 = std::max(tri.x0, bx0), x1 = std::min(tri.x1, bx1);
+                const int y0 = std::max(tri.y0, by0), y1 = std::min(tri.y1, by1);
+                const float invArea = 1.0f / tri.area;
+                for (int y = y0; y <= y1; y++) {
+                    const float py = (float)y + 0.5f;
+                    for (int x = x0; x <= x1; x++) {
+                        const float px = (float)x + 0.5f;
+                        const float w0 = rasterEdge(tri.p[1], tri.p[2], px, py);
+                        const float w1 = rasterEdge(tri.p[2], tri.p[0], px, py);
+                        const float w2 = rasterEdge(tri.p[0], tri.p[1], px, py);
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+                        const float z = (w0 * tri.invDepth[0] + w1 * tri.invDepth[1] + w2 * tri.invDepth[2]) * invArea;
+                        const int i = (y - by0) * RASTER_BIN_SIZE + (x - bx0);
+                        if (z > depth[i]) {
+                            depth[i] = z;
+                            visible[i] = &tri;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int y = by0; y <= by1; y++) {
+            for (int x = bx0; x <= bx1; x++) {
+                const int i = (y - by0) * RASTER_BIN_SIZE + (x - bx0);
+                // Компонента directionAt вдоль взгляда равна 1, так что точка - это направление * глубину
+                const float3 dir = rayGen.directionAt((float)x + 0.5f, (float)y + 0.5f);
+                const float3 ray_dir = LiteMath::normalize(dir);
+                if (!visible[i]) {
+                    out_image[y * W + x] = shading.meshes ? shading.shadeRay(world, rayGen.origin, ray_dir)
+                                                          : float3_to_RGBA8(float3(0.0f, 0.0f, 0.0f));
+                    continue;
+                }
+                const float3 hitPos = rayGen.origin + dir / depth[i];
+                const int3 v = rasterHitVoxel(*visible[i], hitPos + gridOffset);
+                const Voxel voxel = world.getVoxel(v.x, v.y, v.z);
+                if ((shading.translucent && materialTable()[voxel.type].transparent()) ||
+                    (shading.meshes && shading.meshes->occluded(rayGen.origin, ray_dir,
+                                                                LiteMath::length(hitPos - rayGen.origin)))) {
+                    out_image[y * W + x] = shading.shadeRay(world, rayGen.origin, ray_dir);
+                    continue;
+                }
+                out_image[y * W + x] = shading.shadeVoxel(world, rayGen.origin, ray_dir, hitPos,
+                                                          world.getNormal(v.x, v.y, v.z), voxel);
+            }
+        }
+    }
+}
+
+inline void renderVoxelWorldRaster(const Camera& camera, const IVoxelWorld& world,
+                                   const std::vector<VoxelChunkMesh>& chunks, RasterState& state,
+                                   uint32_t* out_image, int W, int H,
+                                   const RenderSettings& settings = RenderSettings()) {
+    dispatchVoxelWorld(world, [&](const auto& w) {
+        renderVoxelWorldRasterT(camera, w, chunks, state, out_image, W, H, settings);
+    });
+}
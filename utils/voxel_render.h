@@ -0,0 +1,1145 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/public_camera.h"
+#include "utils/voxel_world.h"
+#include "utils/ray_generator.h"
+#include "utils/mesh_bvh.h"
+#include "utils/texture_atlas.h"
+#include "utils/material_table.h"
+#include "utils/voxel_ao.h"
+#include "utils/voxel_light.h"
+#include "utils/voxel_irradiance.h"
+
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+
+using LiteMath::float3;
+using LiteMath::float4;
+using LiteMath::int2;
+using LiteMath::int3;
+
+// ============ ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ============
+inline float rad_to_deg(float rad) { return rad * 180.0f / LiteMath::M_PI; }
+
+inline uint32_t float3_to_RGBA8(float3 c) {
+    uint8_t r = (uint8_t)(std::clamp(c.x, 0.0f, 1.0f) * 255.0f);
+    uint8_t g = (uint8_t)(std::clamp(c.y, 0.0f, 1.0f) * 255.0f);
+    uint8_t b = (uint8_t)(std::clamp(c.z, 0.0f, 1.0f) * 255.0f);
+    return 0xFF000000 | (r << 16) | (g << 8) | b;
+}
+
+// Билинейная смесь четырех ARGB8 цветов, веса wx, wy в 0..256
+inline uint32_t lerpRGBA8(uint32_t c00, uint32_t c01, uint32_t c10, uint32_t c11, uint32_t wx, uint32_t wy) {
+    uint32_t result = 0xFF000000;
+    for (int shift = 0; shift < 24; shift += 8) {
+        uint32_t a = (c00 >> shift) & 0xFF, b = (c01 >> shift) & 0xFF;
+        uint32_t c = (c10 >> shift) & 0xFF, d = (c11 >> shift) & 0xFF;
+        uint32_t top    = a * (256 - wx) + b * wx;
+        uint32_t bottom = c * (256 - wx) + d * wx;
+        result |= ((top * (256 - wy) + bottom * wy) >> 16) << shift;
+    }
+    return result;
+}
+
+// ============ РЕНДЕРИНГ ============
+// Кадр делится на тайлы RENDER_TILE_SIZE x RENDER_TILE_SIZE
+static constexpr int RENDER_TILE_SIZE = 16;
+
+// Первичное попадание луча; хранится по пикселю для повторного использования между кадрами
+struct PrimaryHit {
+    float3 pos;             // точка попадания в мировых координатах
+    int3   voxel;           // воксель в координатах сетки
+    float  t   = 0.0f;      // расстояние вдоль луча
+    uint32_t material = 0;  // тип вокселя (0 - промах)
+    bool   hit = false;
+    bool   direct = false;  // попадание в воксель без мешей и сред перед ним, его можно репроецировать
+};
+
+// Рассеянный свет под открытым небом, если нет кэша освещенности
+static constexpr float AMBIENT_LIGHT = 0.25f;
+
+// Освещение в точке попадания от всех включенных источников
+struct HitLighting {
+    float sunlight  = 1.0f;     // множитель прямого света (интенсивность солнца, 0 в тени)
+    float occlusion = 1.0f;     // множитель всего освещения из запеченного AO
+    float sky       = 1.0f;     // яркость небесного света, гасит прямой свет
+    float block     = 0.0f;     // яркость света излучающих материалов
+    float3 ambient  = float3(AMBIENT_LIGHT); // рассеянный свет: константа под небом или из кэша
+
+    // Множитель альбедо по каналам: ambient + Ламберт или свет излучателей, что ярче
+    float3 factor(const float3& normal, const float3& light_dir) const {
+        const float lambert = std::max(0.0f, LiteMath::dot(normal, -light_dir));
+        return LiteMath::max(ambient + float3(sky * 0.75f * sunlight * lambert), float3(block)) * occlusion;
+    }
+};
+
+// Что из освещения включено в кадре, все поля необязательны
+struct RenderLighting {
+    const DirectedLight* sun = nullptr;     // свет идет от солнца, трассируются тени
+    const VoxelAO* ao = nullptr;            // запеченное затенение граней
+    const VoxelLight* light = nullptr;      // распространенный свет неба и излучателей
+    const IrradianceCache* irradiance = nullptr; // накопленный рассеянный свет граней
+};
+
+// Освещение точки попадания: Ламберт + ambient, излучающие материалы не затеняются
+inline uint32_t shadeHit(const float3& normal, const Voxel& voxel, const float3& light_dir,
+                         const HitLighting& lighting = HitLighting()) {
+    const MaterialInfo& material = materialTable()[voxel.type];
+    if (material.emissive()) return material.albedo;
+    
+    // Цвет из таблицы материалов
+    float3 base_color = VoxelMaterials::getColorAsFloat3(material.albedo);
+    return float3_to_RGBA8(base_color * lighting.factor(normal, light_dir));
+}
+
+// ============ ТЕКСТУРЫ БЛОКОВ ============
+// Текстуры граней берутся из таблицы материалов (MaterialInfo::faces).
+// UV грани берутся из точки попадания DDA (дробные части координат сетки
+// вдоль грани), уровень мипа - из расстояния: тексель уровня L должен
+// покрывать не меньше пикселя, т.е. L = floor(log2(t * pixelSpread * tileSize)).
+struct BlockTextures {
+    const TextureAtlas* atlas = nullptr;
+    float pixelSpread = 0.0f;       // ширина пикселя на расстоянии 1 (ставит рендер на кадр)
+
+    // Привязывает таблицу материалов к атласу
+    static BlockTextures bind(const TextureAtlas& atlas) {
+        materialTable().bindTextures(atlas);
+        BlockTextures textures;
+        textures.atlas = &atlas;
+        return textures;
+    }
+
+    // ARGB8 альбедо в точке gridPos (координаты сетки) грани с нормалью normal
+    uint32_t albedo(const MaterialInfo& material, const float3& normal, const float3& gridPos, float t) const {
+        const int face = normal.y > 0.5f ? MaterialInfo::TOP : (normal.y < -0.5f ? MaterialInfo::BOTTOM : MaterialInfo::SIDE);
+        const int texture = material.faces[face];
+        if (texture < 0) return material.albedo;
+
+        float u, v;
+        if (fabsf(normal.x) > 0.5f)      { u = gridPos.z; v = -gridPos.y; }
+        else if (fabsf(normal.z) > 0.5f) { u = gridPos.x; v = -gridPos.y; }
+        else                             { u = gridPos.x; v = gridPos.z; }
+        u -= floorf(u);
+        v -= floorf(v);
+
+        const float footprint = t * pixelSpread * (float)atlas->tileSize();
+        const int level = footprint < 2.0f ? 0 : std::min(std::ilogb(footprint), atlas->levels() - 1);
+        return atlas->sample(texture, u, v, level);
+    }
+};
+
+// Умножение ARGB8 цвета на scale в 0..256 (каналы парами, как в TextureAtlas::bilerp)
+inline uint32_t scaleRGBA8(uint32_t c, uint32_t scale) {
+    const uint32_t rb = (((c & 0x00FF00FFu) * scale) >> 8) & 0x00FF00FFu;
+    const uint32_t g  = (((c & 0x0000FF00u) * scale) >> 8) & 0x0000FF00u;
+    return 0xFF000000u | rb | g;
+}
+
+// Покомпонентное умножение ARGB8 цвета на scale, каналы насыщаются на 255
+inline uint32_t modulateRGBA8(uint32_t c, const float3& scale) {
+    return float3_to_RGBA8(VoxelMaterials::getColorAsFloat3(c) * scale);
+}
+
+// Текстурированный вариант shadeHit: то же освещение, альбедо из атласа
+inline uint32_t shadeHitTextured(const float3& normal, const Voxel& voxel, const float3& light_dir,
+                                 const float3& gridPos, float t, const BlockTextures& textures,
+                                 const HitLighting& lighting = HitLighting()) {
+    const MaterialInfo& material = materialTable()[voxel.type];
+    const uint32_t albedo = textures.albedo(material, normal, gridPos, t);
+    if (material.emissive()) return albedo;
+    const float3 factor = lighting.factor(normal, light_dir);
+    if (factor.x == factor.y && factor.y == factor.z)
+        return scaleRGBA8(albedo, (uint32_t)(std::min(1.0f, factor.x) * 256.0f));
+    return modulateRGBA8(albedo, factor);
+}
+
+// Воксель попадания в координатах сетки. hitPos лежит на границе вокселя с
+// погрешностью накопления t, поэтому ищем твердую клетку при нескольких
+// сдвигах вглубь по лучу.
+template<class World>
+inline int3 hitVoxelCell(const World& world, const float3& hitPos, const float3& ray_dir) {
+    const float3 g = hitPos + voxelGridOffset(world);
+    int3 cell;
+    for (float eps : {1e-3f, 1e-2f, 5e-2f}) {
+        float3 p = g + ray_dir * eps;
+        cell = int3((int)floorf(p.x), (int)floorf(p.y), (int)floorf(p.z));
+        if (world.isSolid(cell.x, cell.y, cell.z)) break;
+    }
+    return cell;
+}
+
+// ============ ТЕНИ ОТ СОЛНЦА ============
+// Теневой луч выпускается из точки попадания, отступившей назад по лучу
+// камеры: так он начинается в пустой клетке, а не на границе твердой.
+static constexpr float SHADOW_RAY_OFFSET = 1e-2f;
+static constexpr float SHADOW_RAY_DIST   = 1000.0f;
+
+// Прямой свет солнца в точке попадания: sun.intensity или 0 в тени.
+// Грани, отвернутые от солнца, и так не освещены - для них луч не нужен.
+template<class World>
+inline float sunlightAt(const World& world, const MeshBVH* meshes, const DirectedLight& sun,
+                        const float3& hitPos, const float3& ray_dir, const float3& normal) {
+    const float3 toSun = LiteMath::normalize(sun.dir);
+    if (LiteMath::dot(normal, toSun) <= 0.0f) return sun.intensity;
+    const float3 origin = hitPos - ray_dir * SHADOW_RAY_OFFSET;
+    if (world.rayOccluded(origin, toSun, SHADOW_RAY_DIST)) return 0.0f;
+    if (meshes && meshes->occluded(origin, toSun, SHADOW_RAY_DIST)) return 0.0f;
+    return sun.intensity;
+}
+
+// Освещение попадания в воксель (meshes - для теней от мешей): AO и свет
+// берутся у грани, через которую луч вошел в воксель
+template<class World>
+inline HitLighting voxelLightingAt(const World& world, const MeshBVH* meshes, const RenderLighting& lighting,
+                                   const float3& hitPos, const float3& ray_dir, const float3& normal) {
+    HitLighting result;
+    if (lighting.sun) result.sunlight = sunlightAt(world, meshes, *lighting.sun, hitPos, ray_dir, normal);
+    if (lighting.ao || lighting.light || lighting.irradiance) {
+        const int3 voxel = hitVoxelCell(world, hitPos, ray_dir);
+        const float3 gridPos = hitPos + voxelGridOffset(world);
+        const int face = nearestVoxelFace(voxel, gridPos);
+        if (lighting.ao) result.occlusion = lighting.ao->lightAt(voxel, gridPos);
+        if (lighting.light) {
+            int sky, block;
+            lighting.light->faceLevels(voxel, face, sky, block);
+            result.sky = lightLevelBrightness(sky);
+            result.block = lightLevelBrightness(block) * (block > 0);
+            result.ambient = float3(AMBIENT_LIGHT * result.sky);
+        }
+        float3 cached;
+        if (lighting.irradiance && lighting.irradiance->lookup(voxel, face, cached)) result.ambient = cached;
+    }
+    return result;
+}
+
+// Освещение попадания в меш: свет берется в клетке перед поверхностью
+template<class World>
+inline HitLighting meshLightingAt(const World& world, const MeshBVH& meshes, const RenderLighting& lighting,
+                                  const float3& hitPos, const float3& ray_dir, const float3& normal) {
+    HitLighting result;
+    if (lighting.sun) result.sunlight = sunlightAt(world, &meshes, *lighting.sun, hitPos, ray_dir, normal);
+    if (lighting.light) {
+        const float3 p = hitPos + voxelGridOffset(world) + normal * 0.5f;
+        int sky, block;
+        lighting.light->levelsAt(int3((int)floorf(p.x), (int)floorf(p.y), (int)floorf(p.z)), sky, block);
+        result.sky = lightLevelBrightness(sky);
+        result.block = lightLevelBrightness(block) * (block > 0);
+        result.ambient = float3(AMBIENT_LIGHT * result.sky);
+    }
+    return result;
+}
+
+// Цвет за полупрозрачной средой спереди назад: альбедо среды, освещенное у
+// ее поверхности, плюс прошедшая сквозь среду доля цвета behind
+template<class World>
+inline uint32_t compositeMedium(const World& world, const MeshBVH* meshes, const RenderLighting* lighting,
+                                const RayMedium& medium, const float3& ray_dir, const float3& light_dir,
+                                uint32_t behind) {
+    if (!medium.entered) return behind;
+    const HitLighting hitLighting = lighting ? voxelLightingAt(world, meshes, *lighting, medium.entryPos, ray_dir,
+                                                               medium.entryNormal)
+                                             : HitLighting();
+    return float3_to_RGBA8(medium.color * hitLighting.factor(medium.entryNormal, light_dir) +
+                           VoxelMaterials::getColorAsFloat3(behind) * medium.transmittance);
+}
+
+// Цвет попадания в воксель без сред перед ним (meshes - для теней от мешей)
+template<class World>
+inline uint32_t shadeVoxelHit(const World& world, const MeshBVH* meshes, const float3& ray_pos, const float3& ray_dir,
+                              const float3& light_dir, const float3& hitPos, const float3& normal, const Voxel& voxel,
+                              const BlockTextures* textures, const RenderLighting* lighting) {
+    const HitLighting hitLighting = lighting ? voxelLightingAt(world, meshes, *lighting, hitPos, ray_dir, normal)
+                                             : HitLighting();
+    return textures ? shadeHitTextured(normal, voxel, light_dir, hitPos + voxelGridOffset(world),
+                                       LiteMath::length(hitPos - ray_pos), *textures, hitLighting)
+                    : shadeHit(normal, voxel, light_dir, hitLighting);
+}
+
+// Цвет одного луча: трассировка через мир + освещение.
+// Если передан primary, в него записывается первичное попадание.
+// ray_dir должен быть нормирован.
+// tStart - расстояние, до которого луч заведомо идет по пустоте (см. beam-проход).
+// Если переданы textures, альбедо берется из атласа.
+// Если передано lighting, к Ламберту добавляются тени, AO и свет по вокселям.
+// Если translucent, луч проходит полупрозрачные материалы насквозь (rayCastTranslucent),
+// а primary описывает непрозрачное попадание за ними.
+template<class World>
+inline uint32_t shadeRay(const World& world, const float3& ray_pos, const float3& ray_dir,
+                         const float3& light_dir, PrimaryHit* primary = nullptr, float tStart = 0.0f,
+                         const BlockTextures* textures = nullptr, const RenderLighting* lighting = nullptr,
+                         bool translucent = false) {
+    float3 hitPos, normal;
+    Voxel hitVoxel;
+    RayMedium medium;
+    const float3 start = ray_pos + ray_dir * tStart;
+    
+    if (translucent ? !world.rayCastTranslucent(start, ray_dir, 1000.0f - tStart, hitPos, normal, hitVoxel, medium)
+                    : !world.rayCast(start, ray_dir, 1000.0f - tStart, hitPos, normal, hitVoxel)) {
+        if (primary) {
+            primary->hit = false;
+            primary->direct = false;
+            primary->material = 0;
+            primary->t = FLT_MAX;
+        }
+        return compositeMedium(world, nullptr, lighting, medium, ray_dir, light_dir,
+                               float3_to_RGBA8(float3(0.0f, 0.0f, 0.0f)));
+    }
+    
+    if (primary) {
+        primary->voxel = hitVoxelCell(world, hitPos, ray_dir);
+        primary->pos   = hitPos;
+        primary->t     = LiteMath::length(hitPos - ray_pos);
+        primary->material = hitVoxel.type;
+        primary->hit   = true;
+        primary->direct = !medium.entered;
+    }
+    const uint32_t color = shadeVoxelHit(world, nullptr, ray_pos, ray_dir, light_dir, hitPos, normal, hitVoxel,
+                                         textures, lighting);
+    return compositeMedium(world, nullptr, lighting, medium, ray_dir, light_dir, color);
+}
+
+// Луч через воксельный мир и меши: сначала BVH мешей, затем DDA до найденного
+// t, так что побеждает ближайшее попадание. Beam-проход знает только воксели,
+// поэтому меши трассируются с нуля, а мир - с tStart. Попадание в меш
+// записывается в primary как непрямое (его нельзя репроецировать по вокселю).
+template<class World>
+inline uint32_t shadeRayWithMeshes(const World& world, const MeshBVH& meshes, const float3& ray_pos,
+                                   const float3& ray_dir, const float3& light_dir, PrimaryHit* primary = nullptr,
+                                   float tStart = 0.0f, const BlockTextures* textures = nullptr,
+                                   const RenderLighting* lighting = nullptr, bool translucent = false) {
+    MeshHit meshHit;
+    const bool hitMesh = meshes.intersect(ray_pos, ray_dir, 1000.0f, meshHit);
+    const float tMax = hitMesh ? meshHit.t : 1000.0f;
+    
+    float3 hitPos, normal;
+    Voxel hitVoxel;
+    RayMedium medium;
+    const float3 start = ray_pos + ray_dir * tStart;
+    if (tStart < tMax &&
+        (translucent ? world.rayCastTranslucent(start, ray_dir, tMax - tStart, hitPos, normal, hitVoxel, medium)
+                     : world.rayCast(start, ray_dir, tMax - tStart, hitPos, normal, hitVoxel)) &&
+        LiteMath::length(hitPos - ray_pos) < tMax) {
+        if (primary) {
+            primary->voxel = hitVoxelCell(world, hitPos, ray_dir);
+            primary->pos   = hitPos;
+            primary->t     = LiteMath::length(hitPos - ray_pos);
+            primary->material = hitVoxel.type;
+            primary->hit   = true;
+            primary->direct = !medium.entered;
+        }
+        const uint32_t color = shadeVoxelHit(world, &meshes, ray_pos, ray_dir, light_dir, hitPos, normal, hitVoxel,
+                                             textures, lighting);
+        return compositeMedium(world, &meshes, lighting, medium, ray_dir, light_dir, color);
+    }
+    if (primary) {
+        primary->pos   = ray_pos + ray_dir * tMax;
+        primary->t     = hitMesh ? meshHit.t : FLT_MAX;
+        primary->material = hitMesh ? meshHit.voxel.type : 0;
+        primary->hit   = hitMesh;
+        primary->direct = false;
+    }
+    uint32_t color = float3_to_RGBA8(float3(0.0f, 0.0f, 0.0f));
+    if (hitMesh && !medium.saturated()) {
+        const float3 meshPos = ray_pos + ray_dir * meshHit.t;
+        const HitLighting hitLighting = lighting ? meshLightingAt(world, meshes, *lighting, meshPos, ray_dir, meshHit.normal)
+                                                 : HitLighting();
+        color = shadeHit(meshHit.normal, meshHit.voxel, light_dir, hitLighting);
+    }
+    return compositeMedium(world, &meshes, lighting, medium, ray_dir, light_dir, color);
+}
+
+// ============ НАСТРОЙКИ КАДРА ============
+// Что включено в кадре, все поля необязательны. Одни и те же настройки
+// передаются во все режимы рендера (полный, репроецирование, прогрессивный,
+// шахматный, растеризация), так что режимы отличаются только способом
+// получения первичной видимости, а освещение и материалы у них общие.
+struct RenderSettings {
+    const VoxelOccupancy* occupancy = nullptr;  // карта занятости для beam-прохода (полный режим)
+    const MeshBVH* meshes = nullptr;            // меши, сливаются с вокселями по ближайшему t
+    const BlockTextures* textures = nullptr;    // текстуры граней вокселей
+    const RenderLighting* lighting = nullptr;   // тени, AO, свет по вокселям, кэш освещенности
+    bool translucent = false;                   // лучи проходят полупрозрачные материалы насквозь
+};
+
+// Настройки, подготовленные к кадру камеры: пустые меши и не построенные AO
+// и свет отбрасываются, текстурам задается размер пикселя, направление света
+// берется у солнца, если оно включено. Хранит указатели на свои поля, поэтому
+// не копируется.
+class FrameShading {
+public:
+    const MeshBVH* meshes = nullptr;
+    const BlockTextures* textures = nullptr;
+    const RenderLighting* lighting = nullptr;
+    bool translucent = false;
+    float3 light_dir;
+
+    FrameShading(const RenderSettings& settings, const RayGenerator& rayGen) : translucent(settings.translucent) {
+        if (settings.meshes && !settings.meshes->empty()) meshes = settings.meshes;
+        if (settings.textures && settings.textures->atlas && !settings.textures->atlas->empty()) {
+            frameTextures = *settings.textures;
+            frameTextures.pixelSpread = LiteMath::length(rayGen.dy);
+            textures = &frameTextures;
+        }
+        if (settings.lighting) {
+            frameLighting = *settings.lighting;
+            if (frameLighting.ao && !frameLighting.ao->built()) frameLighting.ao = nullptr;
+            if (frameLighting.light && !frameLighting.light->built()) frameLighting.light = nullptr;
+            lighting = &frameLighting;
+        }
+        const DirectedLight* sun = lighting ? lighting->sun : nullptr;
+        light_dir = sun ? -LiteMath::normalize(sun->dir) : LiteMath::normalize(float3(-1.0f, -1.0f, -1.0f));
+    }
+    FrameShading(const FrameShading&) = delete;
+    FrameShading& operator=(const FrameShading&) = delete;
+
+    // Полный луч из камеры, как в полном режиме
+    template<class World>
+    uint32_t shadeRay(const World& world, const float3& ray_pos, const float3& ray_dir,
+                      PrimaryHit* primary = nullptr, float tStart = 0.0f) const {
+        return meshes ? shadeRayWithMeshes(world, *meshes, ray_pos, ray_dir, light_dir, primary, tStart, textures,
+                                           lighting, translucent)
+                      : ::shadeRay(world, ray_pos, ray_dir, light_dir, primary, tStart, textures, lighting, translucent);
+    }
+
+    // Попадание в воксель, найденное без трассировки (репроецирование, растеризация)
+    template<class World>
+    uint32_t shadeVoxel(const World& world, const float3& ray_pos, const float3& ray_dir, const float3& hitPos,
+                        const float3& normal, const Voxel& voxel) const {
+        return shadeVoxelHit(world, meshes, ray_pos, ray_dir, light_dir, hitPos, normal, voxel, textures, lighting);
+    }
+
+private:
+    BlockTextures frameTextures;
+    RenderLighting frameLighting;
+};
+
+// ============ BEAM-ПРОХОД ============
+// Для каждого тайла BEAM_TILE_SIZE x BEAM_TILE_SIZE пирамида лучей через его
+// углы шагает по грубой карте занятости. Отрезок пирамиды [s0, s1] (s - глубина
+// вдоль взгляда) лежит в AABB восьми угловых точек, и если в этом AABB нет
+// непустых блоков, все лучи тайла проходят отрезок по пустоте. Результат -
+// глубина, с которой можно начинать DDA, пропуская пустое пространство над рельефом.
+// Глубина консервативна только по карте занятости: до нее ни один луч тайла не
+// задевает непустой блок. Кадр при этом совпадает с полным не побитово: луч
+// стартует из другой точки, и попадание точно в ребро или угол вокселя бэкенд
+// может округлить в соседнюю клетку. Сетка дает тот же кадр, октодерево (вход в
+// лист считается слэб-тестом от начала луча) - единичные пиксели на ребрах.
+static constexpr int   BEAM_TILE_SIZE = 8;
+static constexpr float BEAM_MAX_STEP  = 64.0f;
+
+inline void computeBeamStartDepths(const RayGenerator& rayGen, const VoxelOccupancy& occupancy,
+                                   const float3& gridOffset, float maxDepth, std::vector<float>& depths) {
+    const int W = rayGen.width, H = rayGen.height;
+    const int tilesX = (W + BEAM_TILE_SIZE - 1) / BEAM_TILE_SIZE;
+    const int tilesY = (H + BEAM_TILE_SIZE - 1) / BEAM_TILE_SIZE;
+    depths.resize(tilesX * tilesY);
+    const float3 o = rayGen.origin + gridOffset;
+    
+    #pragma omp parallel for schedule(dynamic, 4)
+    for (int tile = 0; tile < tilesX * tilesY; tile++) {
+        const float x0 = (float)((tile % tilesX) * BEAM_TILE_SIZE);
+        const float y0 = (float)((tile / tilesX) * BEAM_TILE_SIZE);
+        const float x1 = std::min(x0 + BEAM_TILE_SIZE, (float)W);
+        const float y1 = std::min(y0 + BEAM_TILE_SIZE, (float)H);
+        // Направления через внешние углы тайла, компонента вдоль взгляда равна 1
+        const float3 corners[4] = {
+            rayGen.directionAt(x0, y0), rayGen.directionAt(x1, y0),
+            rayGen.directionAt(x0, y1), rayGen.directionAt(x1, y1)
+        };
+        
+        float s = 0.0f;
+        float ds = (float)VoxelOccupancy::BRICK;
+        while (s < maxDepth) {
+            const float s1 = s + ds;
+            float3 mn(FLT_MAX), mx(-FLT_MAX);
+            for (const float3& d : corners) {
+                mn = LiteMath::min(mn, LiteMath::min(o + d * s, o + d * s1));
+                mx = LiteMath::max(mx, LiteMath::max(o + d * s, o + d * s1));
+            }
+            if (!occupancy.anySolid(mn, mx)) {
+                s = s1;
+                ds = std::min(ds * 2.0f, BEAM_MAX_STEP); // пусто - шагаем смелее
+            } else if (ds > VoxelOccupancy::BRICK) {
+                ds *= 0.5f;                               // задели блок - уточняем
+            } else {
+                break;
+            }
+        }
+        depths[tile] = std::min(s, maxDepth);
+    }
+}
+
+// World - конкретный тип мира (GridVoxelWorld, OctreeVoxelWorld) или IVoxelWorld
+// для обобщенного пути с виртуальным вызовом на каждый пиксель.
+// Если передана карта занятости, лучи стартуют с глубины из beam-прохода.
+// Если переданы меши, их попадания сливаются с воксельными по ближайшему t.
+// Если переданы текстуры блоков, грани вокселей текстурируются.
+// Если передано освещение: с солнцем свет идет от него и на каждое освещенное
+// попадание выпускается теневой луч (any-hit rayOccluded), с запеченным AO
+// грани затеняются по нему, со светом по вокселям яркость берется из его уровней,
+// с кэшем освещенности рассеянный свет граней берется из него.
+// Если translucent, лучи проходят полупрозрачные материалы (воду) насквозь.
+template<class World>
+void renderVoxelWorldT(const Camera& camera, const World& world, uint32_t* out_image, int W, int H,
+                       const RenderSettings& settings = RenderSettings()) {
+    
+    const RayGenerator rayGen(camera, W, H);
+    const FrameShading shading(settings, rayGen);
+    
+    std::vector<float> beamDepths;
+    const int beamTilesX = (W + BEAM_TILE_SIZE - 1) / BEAM_TILE_SIZE;
+    if (settings.occupancy && settings.occupancy->built())
+        computeBeamStartDepths(rayGen, *settings.occupancy, voxelGridOffset(world), 1000.0f, beamDepths);
+    
+    const int tilesX = (W + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    const int tilesY = (H + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    const int tileCount = tilesX * tilesY;
+    
+    // Тайлы раздаются потокам по одному из общей очереди: тайлы неба почти
+    // бесплатны, а тайлы рельефа дорогие, поэтому статическое разбиение
+    // дает сильный дисбаланс. Каждый пиксель пишется ровно одним потоком,
+    // так что результат не зависит от числа потоков.
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int tile = 0; tile < tileCount; tile++) {
+        const int x0 = (tile % tilesX) * RENDER_TILE_SIZE;
+        const int y0 = (tile / tilesX) * RENDER_TILE_SIZE;
+        const int x1 = std::min(x0 + RENDER_TILE_SIZE, W);
+        const int y1 = std::min(y0 + RENDER_TILE_SIZE, H);
+        
+        // Убираем антиалиасинг для скорости
+        float dirX[RENDER_TILE_SIZE], dirY[RENDER_TILE_SIZE], dirZ[RENDER_TILE_SIZE];
+        for (int y = y0; y < y1; y++) {
+            rayGen.generateRow(y, x0, x1 - x0, dirX, dirY, dirZ);
+            for (int x = x0; x < x1; x++) {
+                const int i = x - x0;
+                float3 ray_dir(dirX[i], dirY[i], dirZ[i]);
+                float tStart = 0.0f;
+                if (!beamDepths.empty()) {
+                    // Глубина s вдоль взгляда соответствует t = s / cos(угла к оси взгляда)
+                    float s = beamDepths[(y / BEAM_TILE_SIZE) * beamTilesX + x / BEAM_TILE_SIZE];
+                    tStart = 0.999f * s / LiteMath::dot(ray_dir, rayGen.forward);
+                }
+                out_image[y * W + x] = shading.shadeRay(world, rayGen.origin, ray_dir, nullptr, tStart);
+            }
+        }
+    }
+}
+
+// Точка входа для произвольного мира: тип бэкенда определяется один раз за кадр.
+inline void renderVoxelWorld(const Camera& camera, const IVoxelWorld& world, uint32_t* out_image, int W, int H,
+                             const RenderSettings& settings = RenderSettings()) {
+    dispatchVoxelWorld(world, [&](const auto& w) {
+        renderVoxelWorldT(camera, w, out_image, W, H, settings);
+    });
+}
+
+// ============ ОБНОВЛЕНИЕ КЭША ОСВЕЩЕННОСТИ ============
+// Яркость, приходящая по вторичному лучу: небо при промахе, иначе свет,
+// отраженный попавшей гранью (ее освещение берется с тем же кэшем).
+template<class World>
+inline float3 bounceRadiance(const World& world, const RenderLighting& lighting, const float3& origin,
+                             const float3& dir, const float3& light_dir) {
+    float3 hitPos, normal;
+    Voxel voxel;
+    if (!world.rayCast(origin, dir, SHADOW_RAY_DIST, hitPos, normal, voxel))
+        return float3(IRRADIANCE_SKY_R, IRRADIANCE_SKY_G, IRRADIANCE_SKY_B);
+    const MaterialInfo& material = materialTable()[voxel.type];
+    const float3 albedo = VoxelMaterials::getColorAsFloat3(material.albedo);
+    if (material.emissive()) return albedo * ((float)material.emission / LIGHT_MAX);
+    return albedo * voxelLightingAt(world, nullptr, lighting, hitPos, dir, normal).factor(normal, light_dir);
+}
+
+// Экран делится на решетку не более чем из IRRADIANCE_RAYS_PER_FRAME клеток, в
+// каждой берется пиксель со случайным сдвигом. Первичный луч находит видимую
+// грань, вторичный уходит от нее по косинусному распределению. Лучи
+// трассируются параллельно, выборки сливаются в кэш в одном потоке, так что
+// результат не зависит от числа потоков. Меши в кэш не попадают.
+template<class World>
+void updateIrradianceCacheT(const Camera& camera, const World& world, IrradianceCache& cache, int W, int H,
+                            const RenderLighting* lighting = nullptr) {
+    const RayGenerator rayGen(camera, W, H);
+    const DirectedLight* sun = lighting ? lighting->sun : nullptr;
+    const float3 light_dir = sun ? -LiteMath::normalize(sun->dir) : LiteMath::normalize(float3(-1.0f, -1.0f, -1.0f));
+    RenderLighting bounceLighting = lighting ? *lighting : RenderLighting();
+    if (bounceLighting.ao && !bounceLighting.ao->built()) bounceLighting.ao = nullptr;
+    if (bounceLighting.light && !bounceLighting.light->built()) bounceLighting.light = nullptr;
+    bounceLighting.irradiance = &cache;
+    
+    const int cell = std::max(1, (int)ceilf(sqrtf((float)W * H / IRRADIANCE_RAYS_PER_FRAME)));
+    const int cellsX = (W + cell - 1) / cell;
+    const int cellsY = (H + cell - 1) / cell;
+    const uint32_t seed = hashUint32(cache.frame() * 0x9E3779B9u + 1u);
+    
+    struct Sample {
+        int3 voxel;
+        int face = -1;      // -1 - выборки нет
+        float3 irradiance;
+    };
+    std::vector<Sample> samples(cellsX * cellsY);
+    
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < cellsX * cellsY; i++) {
+        uint32_t h = hashUint32(seed ^ hashUint32((uint32_t)i));
+        const int x = std::min((i % cellsX) * cell + (int)(h % (uint32_t)cell), W - 1);
+        h = hashUint32(h);
+        const int y = std::min((i / cellsX) * cell + (int)(h % (uint32_t)cell), H - 1);
+        
+        const float3 ray_dir = rayGen.pixelDirection(x, y);
+        float3 hitPos, normal;
+        Voxel voxel;
+        if (!world.rayCast(rayGen.origin, ray_dir, 1000.0f, hitPos, normal, voxel)) continue;
+        if (materialTable()[voxel.type].emissive()) continue; // излучатели не освещаются
+        const int3 hitCell = hitVoxelCell(world, hitPos, ray_dir);
+        const int face = nearestVoxelFace(hitCell, hitPos + voxelGridOffset(world));
+        
+        // Косинусная выборка полусферы над гранью
+        const int axis = face / 2;
+        const float3 n(VOXEL_FACE_NORMALS[face]);
+        float3 u(0.0f), v(0.0f);
+        u[(axis + 1) % 3] = 1.0f;
+        v[(axis + 2) % 3] = 1.0f;
+        h = hashUint32(h);
+        const float r2 = (h >> 8) * (1.0f / 16777216.0f);
+        h = hashUint32(h);
+        const float phi = 2.0f * LiteMath::M_PI * ((h >> 8) * (1.0f / 16777216.0f));
+        const float r = sqrtf(r2);
+        const float3 dir = n * sqrtf(1.0f - r2) + u * (r * cosf(phi)) + v * (r * sinf(phi));
+        
+        samples[i].voxel = hitCell;
+        samples[i].face = face;
+        samples[i].irradiance = bounceRadiance(world, bounceLighting, hitPos + n * SHADOW_RAY_OFFSET, dir, light_dir);
+    }
+    
+    for (const Sample& sample : samples)
+        if (sample.face >= 0) cache.accumulate(sample.voxel, sample.face, sample.irradiance);
+    cache.nextFrame();
+}
+
+inline void updateIrradianceCache(const Camera& camera, const IVoxelWorld& world, IrradianceCache& cache,
+                                  int W, int H, const RenderLighting* lighting = nullptr) {
+    dispatchVoxelWorld(world, [&](const auto& w) {
+        updateIrradianceCacheT(camera, w, cache, W, H, lighting);
+    });
+}
+
+// ============ ДИНАМИЧЕСКОЕ РАЗРЕШЕНИЕ ============
+// Подбирает внутреннее разрешение рендера так, чтобы время кадра держалось
+// около бюджета targetMs. Стоимость кадра примерно пропорциональна числу
+// пикселей, т.е. квадрату масштаба, отсюда корень в оценке нужного масштаба.
+struct DynamicResolution {
+    float targetMs = 16.6f;   // бюджет на кадр
+    float minScale = 0.25f;   // границы масштаба относительно выходного разрешения
+    float maxScale = 1.0f;
+    float scale    = 1.0f;
+    float avgMs    = 0.0f;    // сглаженное время кадра
+    
+    void update(float frameMs) {
+        avgMs = (avgMs <= 0.0f) ? frameMs : avgMs + 0.2f * (frameMs - avgMs);
+        if (avgMs <= 0.0f) return;
+        
+        // Мертвая зона +-5% чтобы разрешение не дрожало каждый кадр
+        float ratio = targetMs / avgMs;
+        if (ratio > 0.95f && ratio < 1.05f) return;
+        
+        // Вниз быстро (просадка заметна сразу), вверх плавно
+        float desired = scale * sqrtf(ratio);
+        desired = std::clamp(desired, scale * 0.8f, scale * 1.05f);
+        scale = std::clamp(desired, minScale, maxScale);
+    }
+    
+    int2 resolution(int W, int H) const {
+        return int2(std::max(1, (int)(W * scale)), std::max(1, (int)(H * scale)));
+    }
+};
+
+// Билинейное растяжение ARGB8 изображения src (sw x sh) в dst (dw x dh).
+// Целочисленная арифметика с весами 0..256 на канал.
+inline void upscaleBilinear(const uint32_t* src, int sw, int sh, uint32_t* dst, int dw, int dh) {
+    if (sw == dw && sh == dh) {
+        std::copy(src, src + sw * sh, dst);
+        return;
+    }
+    
+    const float sx = (float)sw / dw;
+    const float sy = (float)sh / dh;
+    
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < dh; y++) {
+        float fy = std::clamp((y + 0.5f) * sy - 0.5f, 0.0f, (float)(sh - 1));
+        int y0 = (int)fy;
+        int y1 = std::min(y0 + 1, sh - 1);
+        uint32_t wy = (uint32_t)((fy - y0) * 256.0f);
+        const uint32_t* row0 = src + y0 * sw;
+        const uint32_t* row1 = src + y1 * sw;
+        
+        for (int x = 0; x < dw; x++) {
+            float fx = std::clamp((x + 0.5f) * sx - 0.5f, 0.0f, (float)(sw - 1));
+            int x0 = (int)fx;
+            int x1 = std::min(x0 + 1, sw - 1);
+            uint32_t wx = (uint32_t)((fx - x0) * 256.0f);
+            
+            dst[y * dw + x] = lerpRGBA8(row0[x0], row0[x1], row1[x0], row1[x1], wx, wy);
+        }
+    }
+}
+
+// ============ ТЕМПОРАЛЬНОЕ РЕПРОЕЦИРОВАНИЕ ============
+// Попадания прошлого кадра проецируются в новый вид. Пиксель, получивший
+// кандидата (свой или от соседа), проверяется коротким локальным тестом и
+// закрашивается без обхода мира; полный rayCast идет только для
+// раскрывшихся (disocclusion) и не прошедших проверку пикселей.
+static constexpr int   REPROJECT_CHECK_STEPS     = 8;     // клеток, проверяемых перед точкой входа
+static constexpr float REPROJECT_DEPTH_TOLERANCE = 0.05f; // допустимый разброс глубин в окрестности
+
+struct ReprojectionCache {
+    std::vector<PrimaryHit> hits;      // попадания прошлого кадра
+    int width  = 0;
+    int height = 0;
+    int tracedRays = 0;                // полных rayCast в последнем кадре
+    
+    // Сбросить кэш (например, после редактирования мира)
+    void invalidate() { hits.clear(); width = height = 0; }
+    bool matches(int W, int H) const { return width == W && height == H && !hits.empty(); }
+};
+
+// Проверка, что луч (o, dir) в координатах сетки действительно впервые
+// попадает в воксель v: пересечение с его кубом и пустые клетки на последних
+// REPROJECT_CHECK_STEPS шагах луча перед входом.
+template<class World>
+inline bool validateReprojectedHit(const World& world, const float3& o, const float3& dir,
+                                   const int3& v, float& tEnter) {
+    if (!world.isSolid(v.x, v.y, v.z)) return false;
+    
+    float t0 = 0.0f, t1 = FLT_MAX;
+    int axis = -1;
+    for (int i = 0; i < 3; i++) {
+        float inv = 1.0f / dir[i];
+        float tN = (v[i] - o[i]) * inv;
+        float tF = (v[i] + 1 - o[i]) * inv;
+        if (tN > tF) std::swap(tN, tF);
+        if (tN > t0) { t0 = tN; axis = i; }
+        t1 = std::min(t1, tF);
+        if (t0 > t1) return false;
+    }
+    if (axis < 0) return false; // камера внутри вокселя
+    
+    // Короткий DDA назад от точки входа по клеткам, через которые прошел луч
+    const float3 p = o + dir * t0;
+    int3 cell = v;
+    cell[axis] -= (dir[axis] > 0) ? 1 : -1;
+    int step[3];
+    float tMax[3], tDelta[3];
+    for (int i = 0; i < 3; i++) {
+        float d = -dir[i];
+        step[i] = (d > 0) ? 1 : -1;
+        float next = (step[i] > 0) ? (cell[i] + 1) : cell[i];
+        tMax[i]   = (d != 0) ? (next - p[i]) / d : FLT_MAX;
+        tDelta[i] = (d != 0) ? fabsf(1.0f / d) : FLT_MAX;
+    }
+    for (int k = 0; k < REPROJECT_CHECK_STEPS; k++) {
+        if (world.isSolid(cell.x, cell.y, cell.z)) return false;
+        int i = (tMax[0] < tMax[1]) ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        if (tMax[i] >= t0) break; // дошли до камеры
+        cell[i] += step[i];
+        tMax[i] += tDelta[i];
+    }
+    
+    tEnter = t0;
+    return true;
+}
+
+// Переиспользуются только прямые попадания в воксели (PrimaryHit::direct):
+// пиксели мешей и сред трассируются каждый кадр, а кандидат отвергается,
+// если перед ним оказался меш.
+template<class World>
+void renderVoxelWorldReprojectedT(const Camera& camera, const World& world, ReprojectionCache& cache,
+                                  uint32_t* out_image, int W, int H,
+                                  const RenderSettings& settings = RenderSettings()) {
+    const RayGenerator rayGen(camera, W, H);
+    const FrameShading shading(settings, rayGen);
+    const float3 offset = voxelGridOffset(world);
+    
+    // 1. Разбрасываем попадания прошлого кадра по пикселям нового (ближайшее побеждает).
+    // Последовательно: это O(W*H) простых операций, несравнимо дешевле трассировки.
+    std::vector<int>   candidate(W * H, -1);
+    std::vector<float> candidateDepth(W * H, FLT_MAX);
+    if (cache.matches(W, H)) {
+        for (int i = 0; i < W * H; i++) {
+            const PrimaryHit& h = cache.hits[i];
+            if (!h.hit || !h.direct) continue;
+            float px, py, depth;
+            if (!rayGen.project(h.pos, px, py, depth)) continue;
+            int x = (int)floorf(px), y = (int)floorf(py);
+            if (x < 0 || x >= W || y < 0 || y >= H) continue;
+            if (depth < candidateDepth[y * W + x]) {
+                candidateDepth[y * W + x] = depth;
+                candidate[y * W + x] = i;
+            }
+        }
+    }
+    
+    std::vector<PrimaryHit> hits(W * H);
+    const int tilesX = (W + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    const int tilesY = (H + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    int traced = 0;
+    
+    // 2. Проверяем кандидатов (свой пиксель и 4 соседа), иначе полный rayCast
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:traced)
+    for (int tile = 0; tile < tilesX * tilesY; tile++) {
+        const int x0 = (tile % tilesX) * RENDER_TILE_SIZE;
+        const int y0 = (tile / tilesX) * RENDER_TILE_SIZE;
+        const int x1 = std::min(x0 + RENDER_TILE_SIZE, W);
+        const int y1 = std::min(y0 + RENDER_TILE_SIZE, H);
+        
+        float dirX[RENDER_TILE_SIZE], dirY[RENDER_TILE_SIZE], dirZ[RENDER_TILE_SIZE];
+        for (int y = y0; y < y1; y++) {
+            rayGen.generateRow(y, x0, x1 - x0, dirX, dirY, dirZ);
+            for (int x = x0; x < x1; x++) {
+                const int i = x - x0;
+                const int pixel = y * W + x;
+                float3 ray_dir(dirX[i], dirY[i], dirZ[i]);
+                PrimaryHit& h = hits[pixel];
+                
+                // Ближайшая глубина кандидатов в окрестности 3x3: если пиксель у
+                // силуэта, дальний кандидат мог оказаться закрыт ближним объектом,
+                // которого короткая проверка не видит, поэтому такие не берем
+                float nearestDepth = FLT_MAX;
+                for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, H - 1); ny++)
+                    for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, W - 1); nx++)
+                        nearestDepth = std::min(nearestDepth, candidateDepth[ny * W + nx]);
+                const float maxDepth = nearestDepth * (1.0f + REPROJECT_DEPTH_TOLERANCE);
+                
+                const int neighbours[5] = {
+                    pixel,
+                    x > 0     ? pixel - 1 : -1,
+                    x < W - 1 ? pixel + 1 : -1,
+                    y > 0     ? pixel - W : -1,
+                    y < H - 1 ? pixel + W : -1
+                };
+                bool reused = false;
+                for (int n : neighbours) {
+                    if (n < 0 || candidate[n] < 0 || candidateDepth[n] > maxDepth) continue;
+                    const int3 v = cache.hits[candidate[n]].voxel;
+                    float tEnter;
+                    if (validateReprojectedHit(world, rayGen.origin + offset, ray_dir, v, tEnter) &&
+                        !(shading.meshes && shading.meshes->occluded(rayGen.origin, ray_dir, tEnter))) {
+                        h.pos   = rayGen.origin + ray_dir * tEnter;
+                        h.voxel = v;
+                        const Voxel voxel = world.getVoxel(v.x, v.y, v.z);
+                        h.t     = tEnter;
+                        h.material = voxel.type;
+                        h.hit   = true;
+                        h.direct = true;
+                        out_image[pixel] = shading.shadeVoxel(world, rayGen.origin, ray_dir, h.pos,
+                                                              world.getNormal(v.x, v.y, v.z), voxel);
+                        reused = true;
+                        break;
+                    }
+                }
+                if (!reused) {
+                    out_image[pixel] = shading.shadeRay(world, rayGen.origin, ray_dir, &h);
+                    traced++;
+                }
+            }
+        }
+    }
+    
+    cache.hits.swap(hits);
+    cache.width = W;
+    cache.height = H;
+    cache.tracedRays = traced;
+}
+
+inline void renderVoxelWorldReprojected(const Camera& camera, const IVoxelWorld& world,
+                                        ReprojectionCache& cache, uint32_t* out_image, int W, int H,
+                                        const RenderSettings& settings = RenderSettings()) {
+    dispatchVoxelWorld(world, [&](const auto& w) {
+        renderVoxelWorldReprojectedT(camera, w, cache, out_image, W, H, settings);
+    });
+}
+
+// ============ ПРОГРЕССИВНОЕ УТОЧНЕНИЕ ============
+// Пока камера движется, трассируется только решетка пикселей с шагом
+// movingStep (2 - каждый 4-й пиксель, 4 - каждый 16-й), остальное
+// восстанавливается билинейной интерполяцией. Когда камера остановилась,
+// шаг решетки уменьшается вдвое каждый кадр, уже оттрассированные пиксели
+// переиспользуются, и через log2(movingStep) кадров картинка полная.
+struct ProgressiveState {
+    int movingStep = 2;                 // шаг решетки во время движения (степень двойки, <= RENDER_TILE_SIZE)
+    
+    std::vector<uint32_t> samples;      // оттрассированные цвета
+    std::vector<uint8_t>  traced;       // 1, если пиксель оттрассирован для текущей камеры
+    int width  = 0;
+    int height = 0;
+    int step   = 1;                     // шаг решетки в последнем кадре
+    int tracedRays = 0;                 // лучей в последнем кадре
+    Camera lastCamera;
+    bool hasCamera = false;
+    
+    void invalidate() { hasCamera = false; }
+    bool converged() const { return hasCamera && step == 1; }
+};
+
+// Шаг решетки, округленный вниз до степени двойки в [1, RENDER_TILE_SIZE]: только
+// тогда узлы решетки каждого тайла совпадают с глобальными (x / step) * step,
+// по которым восстанавливаются пропущенные пиксели
+inline int progressiveStep(int movingStep) {
+    int step = 1;
+    while (step * 2 <= std::min(movingStep, RENDER_TILE_SIZE)) step *= 2;
+    return step;
+}
+
+inline bool sameCamera(const Camera& a, const Camera& b) {
+    return LiteMath::length(a.pos - b.pos) == 0.0f && LiteMath::length(a.target - b.target) == 0.0f &&
+           LiteMath::length(a.up - b.up) == 0.0f && a.fov_rad == b.fov_rad;
+}
+
+template<class World>
+void renderVoxelWorldProgressiveT(const Camera& camera, const World& world, ProgressiveState& state,
+                                  uint32_t* out_image, int W, int H,
+                                  const RenderSettings& settings = RenderSettings()) {
+    const RayGenerator rayGen(camera, W, H);
+    const FrameShading shading(settings, rayGen);
+    
+    bool moved = !state.hasCamera || !sameCamera(camera, state.lastCamera) ||
+                 state.width != W || state.height != H;
+    if (moved) {
+        state.samples.assign(W * H, 0xFF000000);
+        state.traced.assign(W * H, 0);
+        state.width = W;
+        state.height = H;
+        state.step = progressiveStep(state.movingStep);
+        state.lastCamera = camera;
+        state.hasCamera = true;
+    } else {
+        state.step = std::max(1, state.step / 2);
+    }
+    const int step = state.step;
+    
+    // 1. Трассируем недостающие узлы решетки текущего шага
+    const int tilesX = (W + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    const int tilesY = (H + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    int traced = 0;
+    
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:traced)
+    for (int tile = 0; tile < tilesX * tilesY; tile++) {
+        const int x0 = (tile % tilesX) * RENDER_TILE_SIZE;
+        const int y0 = (tile / tilesX) * RENDER_TILE_SIZE;
+        const int x1 = std::min(x0 + RENDER_TILE_SIZE, W);
+        const int y1 = std::min(y0 + RENDER_TILE_SIZE, H);
+        
+        // RENDER_TILE_SIZE кратен шагу, поэтому узлы решетки внутри тайла
+        // начинаются с его левого верхнего угла
+        for (int y = y0; y < y1; y += step) {
+            for (int x = x0; x < x1; x += step) {
+                const int pixel = y * W + x;
+                if (state.traced[pixel]) continue;
+                state.samples[pixel] = shading.shadeRay(world, rayGen.origin, rayGen.pixelDirection(x, y));
+                state.traced[pixel] = 1;
+                traced++;
+            }
+        }
+    }
+    state.tracedRays = traced;
+    
+    // 2. Восстанавливаем пропущенные пиксели по узлам решетки
+    const int lastX = ((W - 1) / step) * step; // последний узел по x и y
+    const int lastY = ((H - 1) / step) * step;
+    
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < H; y++) {
+        const int ly0 = (y / step) * step;
+        const int ly1 = std::min(ly0 + step, lastY);
+        const uint32_t wy = (ly1 > ly0) ? (uint32_t)((y - ly0) * 256 / step) : 0;
+        for (int x = 0; x < W; x++) {
+            const int pixel = y * W + x;
+            if (state.traced[pixel]) {
+                out_image[pixel] = state.samples[pixel];
+                continue;
+            }
+            const int lx0 = (x / step) * step;
+            const int lx1 = std::min(lx0 + step, lastX);
+            const uint32_t wx = (lx1 > lx0) ? (uint32_t)((x - lx0) * 256 / step) : 0;
+            out_image[pixel] = lerpRGBA8(state.samples[ly0 * W + lx0], state.samples[ly0 * W + lx1],
+                                         state.samples[ly1 * W + lx0], state.samples[ly1 * W + lx1], wx, wy);
+        }
+    }
+}
+
+inline void renderVoxelWorldProgressive(const Camera& camera, const IVoxelWorld& world,
+                                        ProgressiveState& state, uint32_t* out_image, int W, int H,
+                                        const RenderSettings& settings = RenderSettings()) {
+    dispatchVoxelWorld(world, [&](const auto& w) {
+        renderVoxelWorldProgressiveT(camera, w, state, out_image, W, H, settings);
+    });
+}
+
+// ============ ШАХМАТНЫЙ РЕНДЕР ============
+// Каждый кадр трассируется половина пикселей в шахматном порядке, клетки
+// чередуются между кадрами. Недостающая половина берется из прошлого кадра
+// (там эти пиксели были оттрассированы), если камера стоит, иначе из соседей
+// по горизонтали/вертикали. Соседи усредняются только вдоль направления,
+// где у них совпадает материал и близка глубина, так что края не размываются;
+// на самих краях используется прошлый кадр или ближний по глубине сосед.
+static constexpr float CHECKERBOARD_DEPTH_TOLERANCE = 0.03f; // относительная разница глубин
+
+struct CheckerboardState {
+    std::vector<uint32_t> color[2];     // цвет, глубина и материал текущего и прошлого кадров
+    std::vector<float>    depth[2];
+    std::vector<uint32_t> material[2];
+    int width  = 0;
+    int height = 0;
+    int frame  = 0;                     // номер кадра, младший бит - четность клеток
+    int tracedRays = 0;
+    Camera lastCamera;
+    bool hasHistory = false;
+    
+    void invalidate() { hasHistory = false; }
+};
+
+// Относительная разница глубин; промахи (FLT_MAX) совпадают только с промахами
+inline float relativeDepthDifference(float a, float b) {
+    if (a == FLT_MAX || b == FLT_MAX) return (a == b) ? 0.0f : FLT_MAX;
+    return fabsf(a - b) / std::max(std::min(a, b), 1e-3f);
+}
+
+template<class World>
+void renderVoxelWorldCheckerboardT(const Camera& camera, const World& world, CheckerboardState& state,
+                                   uint32_t* out_image, int W, int H,
+                                   const RenderSettings& settings = RenderSettings()) {
+    const RayGenerator rayGen(camera, W, H);
+    const FrameShading shading(settings, rayGen);
+    
+    if (state.width != W || state.height != H) {
+        for (int i = 0; i < 2; i++) {
+            state.color[i].assign(W * H, 0xFF000000);
+            state.depth[i].assign(W * H, FLT_MAX);
+            state.material[i].assign(W * H, 0);
+        }
+        state.width = W;
+        state.height = H;
+        state.hasHistory = false;
+    }
+    
+    const int cur = state.frame & 1;
+    const int prev = cur ^ 1;
+    const int parity = state.frame & 1;
+    const bool history = state.hasHistory;
+    const bool staticCamera = history && sameCamera(camera, state.lastCamera);
+    uint32_t* color = state.color[cur].data();
+    float* depth = state.depth[cur].data();
+    uint32_t* material = state.material[cur].data();
+    
+    // 1. Трассируем клетки текущей четности
+    const int tilesX = (W + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    const int tilesY = (H + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    int traced = 0;
+    
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:traced)
+    for (int tile = 0; tile < tilesX * tilesY; tile++) {
+        const int x0 = (tile % tilesX) * RENDER_TILE_SIZE;
+        const int y0 = (tile / tilesX) * RENDER_TILE_SIZE;
+        const int x1 = std::min(x0 + RENDER_TILE_SIZE, W);
+        const int y1 = std::min(y0 + RENDER_TILE_SIZE, H);
+        
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0 + ((x0 + y + parity) & 1); x < x1; x += 2) {
+                const int pixel = y * W + x;
+                PrimaryHit h;
+                color[pixel] = shading.shadeRay(world, rayGen.origin, rayGen.pixelDirection(x, y), &h);
+                depth[pixel] = h.t;
+                material[pixel] = h.material;
+                traced++;
+            }
+        }
+    }
+    state.tracedRays = traced;
+    
+    // 2. Восстанавливаем клетки другой четности
+    const uint32_t* prevColor = state.color[prev].data();
+    const float* prevDepth = state.depth[prev].data();
+    const uint32_t* prevMaterial = state.material[prev].data();
+    
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < H; y++) {
+        for (int x = ((y + parity + 1) & 1); x < W; x += 2) {
+            const int pixel = y * W + x;
+            
+            // Соседи: 0 - слева, 1 - справа, 2 - сверху, 3 - снизу (все оттрассированы в этом кадре)
+            const int n[4] = {
+                x > 0     ? pixel - 1 : -1,
+                x < W - 1 ? pixel + 1 : -1,
+                y > 0     ? pixel - W : -1,
+                y < H - 1 ? pixel + W : -1
+            };
+            
+            // Камера не двигалась: пиксель прошлого кадра точен
+            if (staticCamera) {
+                color[pixel] = prevColor[pixel];
+                depth[pixel] = prevDepth[pixel];
+                material[pixel] = prevMaterial[pixel];
+                continue;
+            }
+            
+            // Пространственное восстановление: пара соседей вдоль края
+            float pairDiff[2] = {FLT_MAX, FLT_MAX};
+            for (int p = 0; p < 2; p++) {
+                int a = n[2 * p], b = n[2 * p + 1];
+                if (a >= 0 && b >= 0 && material[a] == material[b])
+                    pairDiff[p] = relativeDepthDifference(depth[a], depth[b]);
+            }
+            int pair = (pairDiff[0] <= pairDiff[1]) ? 0 : 1;
+            if (pairDiff[pair] < CHECKERBOARD_DEPTH_TOLERANCE) {
+                int a = n[2 * pair], b = n[2 * pair + 1];
+                color[pixel] = lerpRGBA8(color[a], color[b], color[a], color[b], 128, 0);
+                depth[pixel] = std::min(depth[a], depth[b]);
+                material[pixel] = material[a];
+                continue;
+            }
+            
+            // На краю согласованной пары нет. Прошлое значение пикселя берем,
+            // если его материал и глубину подтверждает хотя бы один сосед
+            // (при движении камеры оно сдвинуто, поэтому внутри однородных
+            // областей усреднение соседей точнее)
+            bool confirmed = false;
+            for (int i = 0; i < 4 && history && !confirmed; i++) {
+                confirmed = n[i] >= 0 && material[n[i]] == prevMaterial[pixel] &&
+                            relativeDepthDifference(depth[n[i]], prevDepth[pixel]) < CHECKERBOARD_DEPTH_TOLERANCE;
+            }
+            if (confirmed) {
+                color[pixel] = prevColor[pixel];
+                depth[pixel] = prevDepth[pixel];
+                material[pixel] = prevMaterial[pixel];
+                continue;
+            }
+            
+            // Угол или тонкая деталь: берем ближайшего по глубине соседа (передний план)
+            int best = -1;
+            for (int i = 0; i < 4; i++)
+                if (n[i] >= 0 && (best < 0 || depth[n[i]] < depth[best]))
+                    best = n[i];
+            if (best >= 0) {
+                color[pixel] = color[best];
+                depth[pixel] = depth[best];
+                material[pixel] = material[best];
+            }
+        }
+    }
+    
+    std::copy(color, color + W * H, out_image);
+    state.lastCamera = camera;
+    state.hasHistory = true;
+    state.frame++;
+}
+
+inline void renderVoxelWorldCheckerboard(const Camera& camera, const IVoxelWorld& world,
+                                         CheckerboardState& state, uint32_t* out_image, int W, int H,
+                                         const RenderSettings& settings = RenderSettings()) {
+    dispatchVoxelWorld(world, [&](const auto& w) {
+        renderVoxelWorldCheckerboardT(camera, w, state, out_image, W, H, settings);
+    });
+}
@@ -0,0 +1,933 @@
+#pragma once
+
+#include "utils/LiteMath.h"
+#include "utils/material_table.h"
+
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+
+using LiteMath::float3;
+using LiteMath::int3;
+
+// ============ ВОКСЕЛЬНЫЙ ИНТЕРФЕЙС ============
+
+// 1. Структура вокселя. Цвет, текстуры и флаги материала лежат в таблице
+// материалов (utils/material_table.h), воксель хранит только номер материала.
+struct Voxel {
+    uint8_t type;         // номер материала: 0=air, 1=grass, 2=dirt, 3=stone, 4=water
+    uint8_t density;      // плотность
+    uint8_t metadata;     // дополнительные данные
+    
+    Voxel() : type(0), density(0), metadata(0) {}
+    
+    // Простой конструктор
+    explicit Voxel(uint8_t t) : type(t), density(0), metadata(0) {}
+};
+
+// Полупрозрачная среда (материалы с флагом transparent), накопленная лучом
+// спереди назад. Поглощение по закону Бера: на отрезке длины len в вокселе
+// плотности density проходит exp(-TRANSLUCENT_ABSORPTION * density * len).
+static constexpr float TRANSLUCENT_ABSORPTION        = 0.005f;
+static constexpr float TRANSLUCENT_MIN_TRANSMITTANCE = 0.02f;  // ниже - среда непрозрачна, обход обрывается
+
+struct RayMedium {
+    float  transmittance = 1.0f;    // доля света из-за среды, дошедшая до начала луча
+    float3 color;                   // альбедо среды, взвешенное по поглощенной доле
+    float3 entryPos;                // первая полупрозрачная поверхность (мировые координаты)
+    float3 entryNormal;
+    Voxel  entryVoxel;
+    bool   entered = false;
+    
+    bool saturated() const { return transmittance < TRANSLUCENT_MIN_TRANSMITTANCE; }
+    
+    // Отрезок длины len в полупрозрачном вокселе с альбедо albedo (ARGB8)
+    void absorb(uint32_t albedo, uint8_t density, float len) {
+        const float alpha = 1.0f - expf(-TRANSLUCENT_ABSORPTION * density * len);
+        const float w = transmittance * alpha / 255.0f;
+        color += float3((float)((albedo >> 16) & 0xFF), (float)((albedo >> 8) & 0xFF), (float)(albedo & 0xFF)) * w;
+        transmittance *= 1.0f - alpha;
+    }
+};
+
+// 2. Абстрактный интерфейс для воксельного мира
+class IVoxelWorld {
+public:
+    virtual ~IVoxelWorld() = default;
+    
+    // Основные методы доступа
+    virtual Voxel getVoxel(int x, int y, int z) const = 0;
+    virtual bool isSolid(int x, int y, int z) const = 0;
+    virtual float3 getNormal(int x, int y, int z) const = 0;
+    
+    // Информация о размерах
+    virtual int getSizeX() const = 0;
+    virtual int getSizeY() const = 0;
+    virtual int getSizeZ() const = 0;
+    
+    // Для отладки и оптимизации
+    virtual size_t getMemoryUsage() const = 0;
+    virtual std::string getDescription() const = 0;
+    
+    // Метод для трассировки лучей
+    virtual bool rayCast(const float3& origin, const float3& direction,
+                        float maxDist, float3& hitPos, float3& normal,
+                        Voxel& hitVoxel) const = 0;
+    
+    // Есть ли твердый воксель на луче в пределах maxDist (теневые лучи, видимость).
+    // Дешевле rayCast: останавливается на первом твердом и не считает попадание.
+    virtual bool rayOccluded(const float3& origin, const float3& direction, float maxDist) const = 0;
+    
+    // rayCast, который не останавливается на полупрозрачных вокселях, а копит
+    // их в medium и идет дальше с точки выхода. true - попадание в непрозрачный
+    // воксель; false - промах или среда стала непрозрачной (medium.saturated()).
+    virtual bool rayCastTranslucent(const float3& origin, const float3& direction,
+                                    float maxDist, float3& hitPos, float3& normal,
+                                    Voxel& hitVoxel, RayMedium& medium) const = 0;
+};
+
+// 3. DDA-обход регулярной сетки
+// Шаблон по типу мира: для конкретного (final) класса isSolid/getVoxel/getNormal
+// вызываются статически и инлайнятся, для IVoxelWorld - через vtable на каждом шаге.
+template<class World>
+bool rayCastGridDDA(const World& world, const float3& origin, const float3& direction,
+                    float maxDist, float3& hitPos, float3& normal, Voxel& hitVoxel) {
+    const int sizeX = world.getSizeX();
+    const int sizeY = world.getSizeY();
+    const int sizeZ = world.getSizeZ();
+    
+    // Преобразуем мировые координаты в координаты сетки
+    float3 gridOrigin = origin + float3(sizeX/2.0f, 0, sizeZ/2.0f);
+    float3 rayStart = gridOrigin;
+    float3 dir = LiteMath::normalize(direction);
+    float3 pos = rayStart;
+    
+    // Определяем текущий воксель
+    int x = static_cast<int>(floor(pos.x));
+    int y = static_cast<int>(floor(pos.y));
+    int z = static_cast<int>(floor(pos.z));
+    
+    // Проверяем, находимся ли мы внутри сетки
+    if (x < 0 || x >= sizeX || y < 0 || y >= sizeY || z < 0 || z >= sizeZ) {
+        // Находим точку входа в сетку
+        float tMin = 0.0f;
+        float tMax = maxDist;
+        
+        for (int i = 0; i < 3; i++) {
+            if (dir[i] != 0) {
+                float t1 = (0 - pos[i]) / dir[i];
+                float t2 = ((i == 0 ? sizeX : (i == 1 ? sizeY : sizeZ)) - pos[i]) / dir[i];
+                float tNear = std::min(t1, t2);
+                float tFar = std::max(t1, t2);
+                
+                tMin = std::max(tMin, tNear);
+                tMax = std::min(tMax, tFar);
+                
+                if (tMin > tMax) return false;
+            }
+        }
+        
+        if (tMin > 0) {
+            pos = pos + dir * tMin;
+            // Дальнейшие расстояния отсчитываются от точки входа
+            rayStart = pos;
+            maxDist -= tMin;
+            // Точка входа лежит на грани сетки, округление может вынести ее наружу
+            x = std::clamp(static_cast<int>(floor(pos.x)), 0, sizeX - 1);
+            y = std::clamp(static_cast<int>(floor(pos.y)), 0, sizeY - 1);
+            z = std::clamp(static_cast<int>(floor(pos.z)), 0, sizeZ - 1);
+        } else {
+            return false;
+        }
+    }
+    
+    // Шаги по осям
+    int stepX = (dir.x > 0) ? 1 : -1;
+    int stepY = (dir.y > 0) ? 1 : -1;
+    int stepZ = (dir.z > 0) ? 1 : -1;
+    
+    // Расстояние до следующей границы вокселя
+    float nextX = (stepX > 0) ? (x + 1) : x;
+    float nextY = (stepY > 0) ? (y + 1) : y;
+    float nextZ = (stepZ > 0) ? (z + 1) : z;
+    
+    float tMaxX = (dir.x != 0) ? (nextX - pos.x) / dir.x : FLT_MAX;
+    float tMaxY = (dir.y != 0) ? (nextY - pos.y) / dir.y : FLT_MAX;
+    float tMaxZ = (dir.z != 0) ? (nextZ - pos.z) / dir.z : FLT_MAX;
+    
+    // Расстояние для перехода к следующему вокселю
+    float tDeltaX = (dir.x != 0) ? fabs(1.0f / dir.x) : FLT_MAX;
+    float tDeltaY = (dir.y != 0) ? fabs(1.0f / dir.y) : FLT_MAX;
+    float tDeltaZ = (dir.z != 0) ? fabs(1.0f / dir.z) : FLT_MAX;
+    
+    float distance = 0;
+    
+    // Основной цикл DDA
+    while (distance < maxDist) {
+        // Проверяем границы
+        if (x < 0 || x >= sizeX || y < 0 || y >= sizeY || z < 0 || z >= sizeZ) {
+            break;
+        }
+        
+        // Проверяем, попали ли в воксель поверхности
+        if (world.isSolid(x, y, z)) {
+            hitPos = pos - float3(sizeX/2.0f, 0, sizeZ/2.0f);
+            hitVoxel = world.getVoxel(x, y, z);
+            normal = world.getNormal(x, y, z);
+            return true;
+        }
+        
+        // Переход к следующему вокселю
+        if (tMaxX < tMaxY && tMaxX < tMaxZ) {
+            x += stepX;
+            distance = tMaxX;
+            tMaxX += tDeltaX;
+        } else if (tMaxY < tMaxZ) {
+            y += stepY;
+            distance = tMaxY;
+            tMaxY += tDeltaY;
+        } else {
+            z += stepZ;
+            distance = tMaxZ;
+            tMaxZ += tDeltaZ;
+        }
+        
+        // Обновляем позицию
+        pos = rayStart + dir * distance;
+    }
+    
+    return false;
+}
+
+// DDA для запросов видимости: тот же обход, но без позиции, нормали и вокселя
+// попадания. t отсчитывается от origin, а не накапливается от точки входа.
+template<class World>
+bool rayOccludedGridDDA(const World& world, const float3& origin, const float3& direction, float maxDist) {
+    const int size[3] = { world.getSizeX(), world.getSizeY(), world.getSizeZ() };
+    const float3 o = origin + float3(size[0]/2.0f, 0, size[2]/2.0f);
+    const float3 dir = LiteMath::normalize(direction);
+    
+    // Отрезок луча внутри сетки
+    float tMin = 0.0f, tMax = maxDist;
+    for (int i = 0; i < 3; i++) {
+        if (dir[i] != 0) {
+            float t1 = (0 - o[i]) / dir[i];
+            float t2 = (size[i] - o[i]) / dir[i];
+            tMin = std::max(tMin, std::min(t1, t2));
+            tMax = std::min(tMax, std::max(t1, t2));
+        } else if (o[i] < 0 || o[i] >= size[i]) {
+            return false;
+        }
+    }
+    if (tMin >= tMax) return false;
+    
+    const float3 pos = o + dir * tMin;
+    int3 cell(std::clamp(static_cast<int>(floor(pos.x)), 0, size[0] - 1),
+              std::clamp(static_cast<int>(floor(pos.y)), 0, size[1] - 1),
+              std::clamp(static_cast<int>(floor(pos.z)), 0, size[2] - 1));
+    
+    int step[3];
+    float tNext[3], tDelta[3];
+    for (int i = 0; i < 3; i++) {
+        step[i] = (dir[i] > 0) ? 1 : -1;
+        tNext[i] = (dir[i] != 0) ? ((cell[i] + (step[i] > 0 ? 1 : 0)) - o[i]) / dir[i] : FLT_MAX;
+        tDelta[i] = (dir[i] != 0) ? fabs(1.0f / dir[i]) : FLT_MAX;
+    }
+    
+    float t = tMin;
+    while (t < tMax) {
+        if (world.isSolid(cell.x, cell.y, cell.z)) return true;
+        
+        const int axis = (tNext[0] < tNext[1] && tNext[0] < tNext[2]) ? 0 : (tNext[1] < tNext[2] ? 1 : 2);
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= size[axis]) break;
+        t = tNext[axis];
+        tNext[axis] += tDelta[axis];
+    }
+    return false;
+}
+
+// DDA сквозь полупрозрачные воксели: тот же обход, что у rayOccludedGridDDA,
+// твердые клетки с флагом transparent поглощаются в medium, обход идет
+// дальше. t отсчитывается от origin, обход начинается с tStart. Если передан
+// resumeT, обход возвращает false на первой пустой клетке после среды и
+// пишет туда ее t - так бэкенд со своим ускорителем пустоты продолжает сам.
+template<class World>
+bool rayCastTranslucentGridDDA(const World& world, const float3& origin, const float3& direction,
+                               float maxDist, float3& hitPos, float3& normal, Voxel& hitVoxel,
+                               RayMedium& medium, float tStart = 0.0f, float* resumeT = nullptr) {
+    if (resumeT) *resumeT = -1.0f;
+    const int size[3] = { world.getSizeX(), world.getSizeY(), world.getSizeZ() };
+    const float3 offset(size[0]/2.0f, 0, size[2]/2.0f);
+    const float3 o = origin + offset;
+    const float3 dir = LiteMath::normalize(direction);
+    
+    // Отрезок луча внутри сетки
+    float tMin = tStart, tMax = maxDist;
+    for (int i = 0; i < 3; i++) {
+        if (dir[i] != 0) {
+            float t1 = (0 - o[i]) / dir[i];
+            float t2 = (size[i] - o[i]) / dir[i];
+            tMin = std::max(tMin, std::min(t1, t2));
+            tMax = std::min(tMax, std::max(t1, t2));
+        } else if (o[i] < 0 || o[i] >= size[i]) {
+            return false;
+        }
+    }
+    if (tMin >= tMax) return false;
+    
+    const float3 pos = o + dir * tMin;
+    int3 cell(std::clamp(static_cast<int>(floor(pos.x)), 0, size[0] - 1),
+              std::clamp(static_cast<int>(floor(pos.y)), 0, size[1] - 1),
+              std::clamp(static_cast<int>(floor(pos.z)), 0, size[2] - 1));
+    
+    int step[3];
+    float tNext[3], tDelta[3];
+    for (int i = 0; i < 3; i++) {
+        step[i] = (dir[i] > 0) ? 1 : -1;
+        tNext[i] = (dir[i] != 0) ? ((cell[i] + (step[i] > 0 ? 1 : 0)) - o[i]) / dir[i] : FLT_MAX;
+        tDelta[i] = (dir[i] != 0) ? fabs(1.0f / dir[i]) : FLT_MAX;
+    }
+    
+    float t = tMin;
+    bool inMedium = false;
+    while (t < tMax) {
+        const int axis = (tNext[0] < tNext[1] && tNext[0] < tNext[2]) ? 0 : (tNext[1] < tNext[2] ? 1 : 2);
+        if (world.isSolid(cell.x, cell.y, cell.z)) {
+            const Voxel voxel = world.getVoxel(cell.x, cell.y, cell.z);
+            const MaterialInfo& material = materialTable()[voxel.type];
+            if (!material.transparent()) {
+                hitPos = o + dir * t - offset;
+                hitVoxel = voxel;
+                normal = world.getNormal(cell.x, cell.y, cell.z);
+                return true;
+            }
+            if (!medium.entered) {
+                medium.entered = true;
+                medium.entryPos = o + dir * t - offset;
+                medium.entryNormal = world.getNormal(cell.x, cell.y, cell.z);
+                medium.entryVoxel = voxel;
+            }
+            medium.absorb(material.albedo, voxel.density, std::min(tNext[axis], tMax) - t);
+            if (medium.saturated()) return false;
+            inMedium = true;
+        } else if (inMedium && resumeT) {
+            *resumeT = t;
+            return false;
+        }
+        
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= size[axis]) break;
+        t = tNext[axis];
+        tNext[axis] += tDelta[axis];
+    }
+    return false;
+}
+
+// 4. Реализация на основе регулярной сетки
+class GridVoxelWorld final : public IVoxelWorld {
+private:
+    std::vector<std::vector<std::vector<Voxel>>> grid;
+    int sizeX, sizeY, sizeZ;
+    
+public:
+    GridVoxelWorld(int sx, int sy, int sz) : sizeX(sx), sizeY(sy), sizeZ(sz) {
+        grid.resize(sizeX);
+        for (int x = 0; x < sizeX; x++) {
+            grid[x].resize(sizeY);
+            for (int y = 0; y < sizeY; y++) {
+                grid[x][y].resize(sizeZ);
+                // Инициализируем все как воздух
+                for (int z = 0; z < sizeZ; z++) {
+                    grid[x][y][z] = Voxel(0);
+                }
+            }
+        }
+    }
+    
+    // Установка вокселя (для генерации ландшафта)
+    void setVoxel(int x, int y, int z, const Voxel& voxel) {
+        if (x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ) {
+            grid[x][y][z] = voxel;
+        }
+    }
+    
+    // Реализация интерфейса
+    Voxel getVoxel(int x, int y, int z) const override {
+        if (x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ) {
+            return grid[x][y][z];
+        }
+        return Voxel(0); // Возвращаем воздух вне границ
+    }
+    
+    bool isSolid(int x, int y, int z) const override {
+        if (x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ) {
+            return grid[x][y][z].type != 0; // 0 = воздух
+        }
+        return false;
+    }
+    
+    float3 getNormal(int x, int y, int z) const override {
+        // Вычисляем нормаль по соседям
+        float3 normal(0.0f, 0.0f, 0.0f);
+        
+        if (x > 0 && !isSolid(x-1, y, z)) normal.x = -1.0f;
+        else if (x < sizeX-1 && !isSolid(x+1, y, z)) normal.x = 1.0f;
+        
+        if (y > 0 && !isSolid(x, y-1, z)) normal.y = -1.0f;
+        else if (y < sizeY-1 && !isSolid(x, y+1, z)) normal.y = 1.0f;
+        
+        if (z > 0 && !isSolid(x, y, z-1)) normal.z = -1.0f;
+        else if (z < sizeZ-1 && !isSolid(x, y, z+1)) normal.z = 1.0f;
+        
+        if (LiteMath::length(normal) < 0.1f) {
+            return float3(0.0f, 1.0f, 0.0f);
+        }
+        
+        return LiteMath::normalize(normal);
+    }
+    
+    bool rayCast(const float3& origin, const float3& direction,
+                float maxDist, float3& hitPos, float3& normal,
+                Voxel& hitVoxel) const override {
+        return rayCastGridDDA(*this, origin, direction, maxDist, hitPos, normal, hitVoxel);
+    }
+    
+    bool rayOccluded(const float3& origin, const float3& direction, float maxDist) const override {
+        return rayOccludedGridDDA(*this, origin, direction, maxDist);
+    }
+    
+    bool rayCastTranslucent(const float3& origin, const float3& direction,
+                            float maxDist, float3& hitPos, float3& normal,
+                            Voxel& hitVoxel, RayMedium& medium) const override {
+        return rayCastTranslucentGridDDA(*this, origin, direction, maxDist, hitPos, normal, hitVoxel, medium);
+    }
+    
+    int getSizeX() const override { return sizeX; }
+    int getSizeY() const override { return sizeY; }
+    int getSizeZ() const override { return sizeZ; }
+    
+    size_t getMemoryUsage() const override {
+        return sizeX * sizeY * sizeZ * sizeof(Voxel);
+    }
+    
+    std::string getDescription() const override {
+        return "Grid Voxel World (" + std::to_string(sizeX) + "x" + 
+               std::to_string(sizeY) + "x" + std::to_string(sizeZ) + ")";
+    }
+};
+
+// 5. Утилиты для материалов
+namespace VoxelMaterials {
+    // Номера материалов по умолчанию (см. DEFAULT_MATERIALS)
+    const uint8_t AIR   = 0;
+    const uint8_t GRASS = 1;
+    const uint8_t DIRT  = 2;
+    const uint8_t STONE = 3;
+    const uint8_t WATER = 4;
+    
+    inline Voxel createVoxel(uint8_t type) {
+        return Voxel(type);
+    }
+    
+    inline Voxel createAir() {
+        return createVoxel(AIR);
+    }
+    
+    inline Voxel createGrass() {
+        return createVoxel(GRASS);
+    }
+    
+    inline Voxel createDirt() {
+        return createVoxel(DIRT);
+    }
+    
+    inline Voxel createStone() {
+        return createVoxel(STONE);
+    }
+    
+    inline Voxel createWater() {
+        Voxel v = createVoxel(WATER);
+        v.density = 100; // Вода имеет плотность
+        return v;
+    }
+    
+    inline float3 getColorAsFloat3(uint32_t color) {
+        float r = ((color >> 16) & 0xFF) / 255.0f;
+        float g = ((color >> 8) & 0xFF) / 255.0f;
+        float b = (color & 0xFF) / 255.0f;
+        return float3(r, g, b);
+    }
+}
+
+// 6. Генератор ландшафта
+namespace TerrainGenerator {
+    inline void createHillyTerrain(GridVoxelWorld& world) {
+        int sizeX = world.getSizeX();
+        int sizeY = world.getSizeY();
+        int sizeZ = world.getSizeZ();
+        
+        float baseHeight = sizeY * 0.3f;
+        
+        for (int x = 0; x < sizeX; x++) {
+            for (int z = 0; z < sizeZ; z++) {
+                // Периодическая функция для высоты
+                float fx = sin(x * 0.1f) * 0.7f;
+                float fz = cos(z * 0.08f) * 0.5f;
+                float hills = sin(x * 0.03f + z * 0.05f) * 1.2f;
+                float height = baseHeight + (fx + fz + hills) * 8.0f;
+                
+                int y_height = static_cast<int>(height);
+                y_height = std::clamp(y_height, 0, sizeY - 1);
+                
+                // Заполняем столбец вокселей с разными материалами
+                for (int y = 0; y <= y_height; y++) {
+                    Voxel voxel;
+                    
+                    if (y == y_height) {
+                        // Поверхность - трава
+                        voxel = VoxelMaterials::createGrass();
+                    } else if (y > y_height - 5) {
+                        // Верхний слой - земля
+                        voxel = VoxelMaterials::createDirt();
+                    } else {
+                        // Нижние слои - камень
+                        voxel = VoxelMaterials::createStone();
+                    }
+                    
+                    world.setVoxel(x, y, z, voxel);
+                }
+            }
+        }
+        
+        // Добавляем озеро в центре
+        int centerX = sizeX / 2;
+        int centerZ = sizeZ / 2;
+        int lakeRadius = 15;
+        
+        for (int x = centerX - lakeRadius; x <= centerX + lakeRadius; x++) {
+            for (int z = centerZ - lakeRadius; z <= centerZ + lakeRadius; z++) {
+                float dx = x - centerX;
+                float dz = z - centerZ;
+                float dist = sqrt(dx*dx + dz*dz);
+                
+                if (dist <= lakeRadius) {
+                    // Убираем землю под озером
+                    for (int y = 0; y < 10; y++) {
+                        world.setVoxel(x, y, z, VoxelMaterials::createAir());
+                    }
+                    // Добавляем воду
+                    for (int y = 10; y < 12; y++) {
+                        if (x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ) {
+                            world.setVoxel(x, y, z, VoxelMaterials::createWater());
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    inline void createFlatTerrain(GridVoxelWorld& world, float height = 20.0f) {
+        // Простая плоская местность для тестирования
+        int sizeX = world.getSizeX();
+        int sizeY = world.getSizeY();
+        int sizeZ = world.getSizeZ();
+        
+        int y_height = static_cast<int>(height);
+        y_height = std::clamp(y_height, 0, sizeY - 1);
+        
+        for (int x = 0; x < sizeX; x++) {
+            for (int z = 0; z < sizeZ; z++) {
+                for (int y = 0; y <= y_height; y++) {
+                    Voxel voxel;
+                    if (y == y_height) {
+                        voxel = VoxelMaterials::createGrass();
+                    } else {
+                        voxel = VoxelMaterials::createDirt();
+                    }
+                    world.setVoxel(x, y, z, voxel);
+                }
+            }
+        }
+    }
+}
+
+// ============ ОКТОДЕРЕВО =============
+struct OctreeNode {
+    bool isLeaf = true;
+    bool solid = false;      // есть ли хотя бы один solid
+    Voxel voxel;             // если однородный
+    int3 min;                // inclusive
+    int3 max;                // exclusive
+    std::unique_ptr<OctreeNode> children[8];
+};
+
+class OctreeVoxelWorld final : public IVoxelWorld {
+public:
+    OctreeVoxelWorld(const GridVoxelWorld& grid) {
+        sizeX = grid.getSizeX();
+        sizeY = grid.getSizeY();
+        sizeZ = grid.getSizeZ();
+        root = buildNode(grid, int3(0,0,0), int3(sizeX, sizeY, sizeZ));
+    }
+
+    // ===== интерфейс =====
+    Voxel getVoxel(int x,int y,int z) const override {
+        return getVoxelNode(root.get(), x,y,z);
+    }
+
+    bool isSolid(int x,int y,int z) const override {
+        return getVoxel(x,y,z).type != 0;
+    }
+
+    float3 getNormal(int x,int y,int z) const override {
+        // используем тот же метод, что и Grid
+        float3 n(0,0,0);
+        if (!isSolid(x-1,y,z)) n.x = -1;
+        else if (!isSolid(x+1,y,z)) n.x = 1;
+        if (!isSolid(x,y-1,z)) n.y = -1;
+        else if (!isSolid(x,y+1,z)) n.y = 1;
+        if (!isSolid(x,y,z-1)) n.z = -1;
+        else if (!isSolid(x,y,z+1)) n.z = 1;
+        if (LiteMath::length(n) < 0.1f) return float3(0,1,0);
+        return LiteMath::normalize(n);
+    }
+
+    int getSizeX() const override { return sizeX; }
+    int getSizeY() const override { return sizeY; }
+    int getSizeZ() const override { return sizeZ; }
+
+    size_t getMemoryUsage() const override {
+        return memory;
+    }
+
+    std::string getDescription() const override {
+        return "Octree Voxel World";
+    }
+
+    // ===== rayCast =====
+    bool rayCast(const float3& origin,
+                 const float3& dir,
+                 float maxDist,
+                 float3& hitPos,
+                 float3& normal,
+                 Voxel& hitVoxel) const override
+    {
+        float3 o = origin + float3(sizeX/2.0f, 0, sizeZ/2.0f);
+        float3 d = LiteMath::normalize(dir);
+
+        float tHit = maxDist;
+        bool hit = rayNode(root.get(), o, d, 0.0f, tHit, hitVoxel, hitPos, normal);
+        if (hit)
+            hitPos -= float3(sizeX/2.0f, 0, sizeZ/2.0f);
+        return hit;
+    }
+
+    bool rayOccluded(const float3& origin, const float3& dir, float maxDist) const override {
+        float3 o = origin + float3(sizeX/2.0f, 0, sizeZ/2.0f);
+        return occludedNode(root.get(), o, LiteMath::normalize(dir), maxDist);
+    }
+
+    // Пустоту пропускает дерево, а найденный полупрозрачный участок проходится
+    // DDA от точки входа до выхода в пустую клетку, откуда снова идет дерево
+    bool rayCastTranslucent(const float3& origin, const float3& dir, float maxDist,
+                            float3& hitPos, float3& normal, Voxel& hitVoxel,
+                            RayMedium& medium) const override
+    {
+        const float3 offset(sizeX/2.0f, 0, sizeZ/2.0f);
+        float3 o = origin + offset;
+        float3 d = LiteMath::normalize(dir);
+
+        float t = 0.0f;
+        for (;;) {
+            float tHit = maxDist;
+            if (!rayNode(root.get(), o, d, t, tHit, hitVoxel, hitPos, normal))
+                return false;
+            if (!materialTable()[hitVoxel.type].transparent()) {
+                hitPos -= offset;
+                return true;
+            }
+            float resume;
+            if (rayCastTranslucentGridDDA(*this, origin, d, maxDist, hitPos, normal, hitVoxel, medium, tHit, &resume))
+                return true;
+            if (resume < 0.0f) return false;
+            t = resume;
+        }
+    }
+
+private:
+    std::unique_ptr<OctreeNode> root;
+    int sizeX{}, sizeY{}, sizeZ{};
+    mutable size_t memory = 0;
+
+    // ===== построение =====
+    std::unique_ptr<OctreeNode> buildNode(
+        const GridVoxelWorld& grid,
+        const int3& min,
+        const int3& max)
+    {
+        auto node = std::make_unique<OctreeNode>();
+        node->min = min;
+        node->max = max;
+        memory += sizeof(OctreeNode);
+
+        bool first = true;
+        Voxel ref;
+
+        for (int x=min.x; x<max.x; ++x)
+        for (int y=min.y; y<max.y; ++y)
+        for (int z=min.z; z<max.z; ++z) {
+            Voxel v = grid.getVoxel(x,y,z);
+            if (first) { ref = v; first = false; }
+            else if (v.type != ref.type) {
+                goto split;
+            }
+        }
+
+        node->isLeaf = true;
+        node->voxel = ref;
+        node->solid = (ref.type != 0);
+        return node;
+
+    split:
+        node->isLeaf = false;
+        int3 mid = (min + max) / 2;
+
+        for (int i=0;i<8;i++) {
+            int3 cmin = {
+                (i&1)?mid.x:min.x,
+                (i&2)?mid.y:min.y,
+                (i&4)?mid.z:min.z
+            };
+            int3 cmax = {
+                (i&1)?max.x:mid.x,
+                (i&2)?max.y:mid.y,
+                (i&4)?max.z:mid.z
+            };
+            if (cmin.x<cmax.x && cmin.y<cmax.y && cmin.z<cmax.z)
+                node->children[i] = buildNode(grid,cmin,cmax);
+        }
+        return node;
+    }
+
+    // ===== доступ =====
+    Voxel getVoxelNode(const OctreeNode* n,int x,int y,int z) const {
+        if (n->isLeaf) return n->voxel;
+        for (auto& c : n->children) {
+            if (!c) continue;
+            if (x>=c->min.x && x<c->max.x &&
+                y>=c->min.y && y<c->max.y &&
+                z>=c->min.z && z<c->max.z)
+                return getVoxelNode(c.get(),x,y,z);
+        }
+        return Voxel();
+    }
+
+    // ===== AABB =====
+    static bool rayAABB(const float3& o,const float3& d,
+                        const float3& mn,const float3& mx,
+                        float& t0,float& t1)
+    {
+        for(int i=0;i<3;i++){
+            float inv = 1.0f/d[i];
+            float tN = (mn[i]-o[i])*inv;
+            float tF = (mx[i]-o[i])*inv;
+            if (tN>tF) std::swap(tN,tF);
+            t0 = std::max(t0,tN);
+            t1 = std::min(t1,tF);
+            if (t0>t1) return false;
+        }
+        return true;
+    }
+
+    // ===== рекурсивный rayCast =====
+    bool rayNode(const OctreeNode* n,
+                 const float3& o,const float3& d,
+                 float t0,float& tHit,
+                 Voxel& voxel,
+                 float3& hitPos,
+                 float3& normal) const
+    {
+        float t1 = tHit;
+        if (!rayAABB(o,d,
+            float3(n->min),float3(n->max),t0,t1))
+            return false;
+
+        if (n->isLeaf) {
+            if (!n->solid) return false;
+
+            float t = std::max(t0, 0.0f) + 1e-4f;
+            float3 pos = o + d * t;
+
+            int x = int(floor(pos.x));
+            int y = int(floor(pos.y));
+            int z = int(floor(pos.z));
+
+            int stepX = (d.x > 0) ? 1 : -1;
+            int stepY = (d.y > 0) ? 1 : -1;
+            int stepZ = (d.z > 0) ? 1 : -1;
+
+            float nextX = (stepX > 0) ? (x + 1) : x;
+            float nextY = (stepY > 0) ? (y + 1) : y;
+            float nextZ = (stepZ > 0) ? (z + 1) : z;
+
+            float tMaxX = (d.x != 0) ? (nextX - pos.x) / d.x : FLT_MAX;
+            float tMaxY = (d.y != 0) ? (nextY - pos.y) / d.y : FLT_MAX;
+            float tMaxZ = (d.z != 0) ? (nextZ - pos.z) / d.z : FLT_MAX;
+
+            float tDeltaX = (d.x != 0) ? fabs(1.0f / d.x) : FLT_MAX;
+            float tDeltaY = (d.y != 0) ? fabs(1.0f / d.y) : FLT_MAX;
+            float tDeltaZ = (d.z != 0) ? fabs(1.0f / d.z) : FLT_MAX;
+
+            while (x>=n->min.x && x<n->max.x &&
+                y>=n->min.y && y<n->max.y &&
+                z>=n->min.z && z<n->max.z &&
+                t < tHit)
+            {
+                if (isSolid(x,y,z)) {
+                    voxel = getVoxel(x,y,z);
+                    hitPos = o + d * t;
+                    normal = getNormal(x,y,z);
+                    tHit = t;
+                    return true;
+                }
+
+                if (tMaxX < tMaxY && tMaxX < tMaxZ) {
+                    x += stepX;
+                    t = tMaxX;
+                    tMaxX += tDeltaX;
+                }
+                else if (tMaxY < tMaxZ) {
+                    y += stepY;
+                    t = tMaxY;
+                    tMaxY += tDeltaY;
+                }
+                else {
+                    z += stepZ;
+                    t = tMaxZ;
+                    tMaxZ += tDeltaZ;
+                }
+            }
+            return false;
+        }
+
+        bool hit=false;
+        for (auto& c : n->children)
+            if (c)
+                hit |= rayNode(c.get(),o,d,t0,tHit,voxel,hitPos,normal);
+        return hit;
+    }
+
+    // ===== any-hit =====
+    // Лист однороден, поэтому задетый на [0, tMax] твердый лист - уже ответ:
+    // ни DDA внутри листа, ни порядка обхода потомков не нужно.
+    bool occludedNode(const OctreeNode* n, const float3& o, const float3& d, float tMax) const {
+        float t0 = 0.0f, t1 = tMax;
+        if (!rayAABB(o, d, float3(n->min), float3(n->max), t0, t1))
+            return false;
+        if (n->isLeaf) {
+            if (!n->solid) return false;
+            // Как в rayNode: лист задет, если в нем лежит точка входа, сдвинутая
+            // на 1e-4 вдоль луча, иначе луч, лишь коснувшийся листа, давал бы тень
+            const float t = t0 + 1e-4f;
+            const float3 p = o + d * t;
+            const int x = int(floor(p.x)), y = int(floor(p.y)), z = int(floor(p.z));
+            return t < tMax && x >= n->min.x && x < n->max.x && y >= n->min.y && y < n->max.y &&
+                   z >= n->min.z && z < n->max.z;
+        }
+        for (auto& c : n->children)
+            if (c && occludedNode(c.get(), o, d, tMax))
+                return true;
+        return false;
+    }
+};
+
+// Сдвиг мировых координат в координаты сетки (мир центрирован по X и Z)
+template<class World>
+inline float3 voxelGridOffset(const World& world) {
+    return float3(world.getSizeX()/2.0f, 0, world.getSizeZ()/2.0f);
+}
+
+// ============ ГРУБАЯ КАРТА ЗАНЯТОСТИ =============
+// Мир разбит на блоки BRICK^3. По флагам "в блоке есть твердый воксель"
+// строится трехмерная префиксная сумма, поэтому вопрос "есть ли что-то
+// твердое в AABB" решается за 8 чтений независимо от размера AABB.
+class VoxelOccupancy {
+public:
+    static constexpr int BRICK = 4;
+    
+    template<class World>
+    void build(const World& world) {
+        sizeX = world.getSizeX();
+        sizeY = world.getSizeY();
+        sizeZ = world.getSizeZ();
+        nx = (sizeX + BRICK - 1) / BRICK;
+        ny = (sizeY + BRICK - 1) / BRICK;
+        nz = (sizeZ + BRICK - 1) / BRICK;
+        
+        std::vector<uint8_t> bricks(nx * ny * nz, 0);
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int bx = 0; bx < nx; bx++)
+        for (int by = 0; by < ny; by++)
+        for (int bz = 0; bz < nz; bz++) {
+            bool solid = false;
+            for (int x = bx * BRICK; x < std::min((bx + 1) * BRICK, sizeX) && !solid; x++)
+            for (int y = by * BRICK; y < std::min((by + 1) * BRICK, sizeY) && !solid; y++)
+            for (int z = bz * BRICK; z < std::min((bz + 1) * BRICK, sizeZ) && !solid; z++)
+                solid = world.isSolid(x, y, z);
+            bricks[(bx * ny + by) * nz + bz] = solid ? 1 : 0;
+        }
+        
+        sat.assign((nx + 1) * (ny + 1) * (nz + 1), 0);
+        for (int bx = 0; bx < nx; bx++)
+        for (int by = 0; by < ny; by++)
+        for (int bz = 0; bz < nz; bz++) {
+            sat[index(bx + 1, by + 1, bz + 1)] = bricks[(bx * ny + by) * nz + bz]
+                + sat[index(bx, by + 1, bz + 1)] + sat[index(bx + 1, by, bz + 1)] + sat[index(bx + 1, by + 1, bz)]
+                - sat[index(bx, by, bz + 1)] - sat[index(bx, by + 1, bz)] - sat[index(bx + 1, by, bz)]
+                + sat[index(bx, by, bz)];
+        }
+    }
+    
+    bool built() const { return !sat.empty(); }
+    
+    // Пересекает ли AABB [mn, mx] (координаты сетки) хотя бы один непустой блок
+    bool anySolid(const float3& mn, const float3& mx) const {
+        if (mx.x < 0 || mx.y < 0 || mx.z < 0 || mn.x >= sizeX || mn.y >= sizeY || mn.z >= sizeZ)
+            return false;
+        int x0 = std::max(0, (int)floorf(mn.x) / BRICK), x1 = std::min(nx - 1, (int)floorf(mx.x) / BRICK);
+        int y0 = std::max(0, (int)floorf(mn.y) / BRICK), y1 = std::min(ny - 1, (int)floorf(mx.y) / BRICK);
+        int z0 = std::max(0, (int)floorf(mn.z) / BRICK), z1 = std::min(nz - 1, (int)floorf(mx.z) / BRICK);
+        int count = sat[index(x1 + 1, y1 + 1, z1 + 1)]
+                  - sat[index(x0, y1 + 1, z1 + 1)] - sat[index(x1 + 1, y0, z1 + 1)] - sat[index(x1 + 1, y1 + 1, z0)]
+                  + sat[index(x0, y0, z1 + 1)] + sat[index(x0, y1 + 1, z0)] + sat[index(x1 + 1, y0, z0)]
+                  - sat[index(x0, y0, z0)];
+        return count > 0;
+    }
+    
+    size_t getMemoryUsage() const { return sat.size() * sizeof(int); }
+    
+private:
+    int sizeX = 0, sizeY = 0, sizeZ = 0;
+    int nx = 0, ny = 0, nz = 0;      // число блоков по осям
+    std::vector<int> sat;             // префиксные суммы, (nx+1)*(ny+1)*(nz+1)
+    
+    int index(int x, int y, int z) const { return (x * (ny + 1) + y) * (nz + 1) + z; }
+};
+
+// ============ ДИСПЕТЧЕРИЗАЦИЯ ПО БЭКЕНДУ =============
+// Определяет конкретный тип мира один раз и вызывает f с ним.
+// Внутри f все вызовы isSolid/getVoxel/rayCast статические и могут инлайниться,
+// поэтому виртуальный вызов остается один на кадр, а не один на шаг DDA.
+template<typename F>
+decltype(auto) dispatchVoxelWorld(const IVoxelWorld& world, F&& f) {
+    if (auto grid = dynamic_cast<const GridVoxelWorld*>(&world))
+        return f(*grid);
+    if (auto octree = dynamic_cast<const OctreeVoxelWorld*>(&world))
+        return f(*octree);
+    return f(world); // неизвестный бэкенд - обычный виртуальный путь
+}